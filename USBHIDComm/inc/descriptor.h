@@ -87,10 +87,46 @@ typedef struct
 	/** Size in bytes of the Generic HID reports (including report ID byte). */
 	#define GENERIC_REPORT_SIZE       1//250
 
+	/** Bit offset of the joystick and button status byte in the Generic HID IN report. */
+	#define GENERIC_REPORT_STATUS_OFFSET   HID_VENDOR_REPORT_FIELD_OFFSET(0)
+
+	/** Bit offset of the LED control byte in the Generic HID OUT report. */
+	#define GENERIC_REPORT_LEDS_OFFSET     HID_VENDOR_REPORT_FIELD_OFFSET(0)
+
+	/** Size in bytes of the sampling clock status feature report. */
+	#define GENERIC_FEATURE_REPORT_SIZE    9
+	/** Bit offset of the status flags byte in the feature report, see \ref GENERIC_FEATURE_FLAG_LOCKED. */
+	#define GENERIC_FEATURE_FLAGS_OFFSET   HID_VENDOR_REPORT_FIELD_OFFSET(0)
+	/** Bit offset of the signed 32-bit little endian phase error, in nanoseconds, in the feature report. */
+	#define GENERIC_FEATURE_PHASE_OFFSET   HID_VENDOR_REPORT_FIELD_OFFSET(1)
+	/** Bit offset of the signed 32-bit little endian frequency offset, in parts per billion, in the feature report. */
+	#define GENERIC_FEATURE_FREQ_OFFSET    HID_VENDOR_REPORT_FIELD_OFFSET(5)
+	/** Flag set in the feature report status byte while the sampling clock is locked to the SOF. */
+	#define GENERIC_FEATURE_FLAG_LOCKED    (1 << 0)
+
+	/** Size in bytes of the largest report the device creates, which sizes the class driver's report buffer. */
+	#define GENERIC_MAX_REPORT_SIZE        MAX(GENERIC_REPORT_SIZE, GENERIC_FEATURE_REPORT_SIZE)
+
 
 /*******************************************************************************
  *                     ESTRUTURAS E DEFINICOES DE TIPOS						   *	
  ******************************************************************************/
+/** Indexes of the device's string descriptors, as listed in the device descriptor. */
+enum StringDescriptors_t
+{
+	STRING_ID_Language     = 0, /**< Supported languages string descriptor, must be index zero. */
+	STRING_ID_Manufacturer = 1, /**< Manufacturer string descriptor. */
+	STRING_ID_Product      = 2, /**< Product string descriptor. */
+};
+
+/** Entry of the table \ref CALLBACK_USB_GetDescriptor() looks requested descriptors up in. */
+typedef struct
+{
+	uint8_t     Type;    /**< Descriptor type, a value from \ref USB_DescriptorTypes_t or a class specific type. */
+	uint8_t     Number;  /**< Descriptor index within its type, or the interface number for HID class descriptors. */
+	const void* Address; /**< Location of the descriptor. */
+	uint16_t    Size;    /**< Size of the descriptor in bytes. */
+} USB_DescriptorTableEntry_t;
 
 /*******************************************************************************
  *                       VARIAVEIS PUBLICAS (Globais)						   *
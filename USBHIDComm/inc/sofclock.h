@@ -0,0 +1,145 @@
+#ifndef SOFCLOCK_H_
+#define SOFCLOCK_H_
+
+/** ************************************************************************
+ * Modulo: sofclock
+ * @file sofclock.h
+ * @headerfile sofclock.h
+ * @author Marcelo Martins Maia do Couto - Email: marcelo.m.maia@gmail.com
+ * @date Feb 2, 2016
+ *
+ * @brief Sampling clock disciplined to the USB Start Of Frame.
+ *
+ * TIMER0 runs from the CPU clock with a period of one USB frame, and its match
+ * interrupt is the sampling tick. On every SOF the module measures where in the
+ * timer period the SOF arrived (the phase error, in timer ticks) and feeds it to
+ * a proportional-integral loop that trims the timer period, like a PLL locked to
+ * the host's 1 kHz frame clock. Every board attached to the same host therefore
+ * samples in phase with the others, without resampling on the host.
+ *
+ * The SOF arrival is taken from the cycle stamp latched by the USB interrupt
+ * (see USB_Device_GetFrameTime()), so the time the USB interrupt spends before
+ * calling this module does not show up as phase error.
+ *
+ * Arquivos do módulo:
+ *   - sofclock.c;
+ *   - sofclock.h.
+ *
+ * @copyright Copyright 2015 M3C Tecnologia
+ * @copyright Todos os direitos reservados.
+ *
+ * @note
+ *  - While no SOF is received (bus suspended or detached), the timer keeps
+ *    running at the last trimmed period and the loop reports itself unlocked
+ *    after SOFCLOCK_HOLDOVER_FRAMES periods.
+ *
+ * @pre
+ *   SOF events must be enabled (USB_Device_EnableSOFEvents()) and
+ *   SOFClock_SOF() called from EVENT_USB_Device_StartOfFrame().
+ *
+ ******************************************************************************/
+
+/*
+ * Inclusão de arquivos de cabeçalho da ferramenta de desenvolvimento.
+ * Por exemplo: '#include <stdlib.h>'.
+ */
+#include <stdint.h>
+#include <stdbool.h>
+
+/*
+ * Inclusão de arquivos de cabeçalho sem um arquivo ".c" correspondente.
+ * Por exemplo: '#include "stddefs.h"'.
+ */
+
+/*
+ * Inclusão de arquivos de cabeçalho de outros módulos utilizados por este.
+ * Por exemplo: '#include "serial.h"'.
+ */
+
+/*******************************************************************************
+ *                           DEFINICOES E MACROS							   *
+ ******************************************************************************/
+	/* Macros: */
+	/** Phase error, in nanoseconds, below which the loop counts towards lock. */
+	#if !defined(SOFCLOCK_LOCK_THRESHOLD_NS)
+		#define SOFCLOCK_LOCK_THRESHOLD_NS     2000
+	#endif
+
+	/** Phase error, in nanoseconds, above which a locked loop drops out of lock. */
+	#if !defined(SOFCLOCK_UNLOCK_THRESHOLD_NS)
+		#define SOFCLOCK_UNLOCK_THRESHOLD_NS   10000
+	#endif
+
+	/** Phase error, in nanoseconds, above which the timer is realigned in one step instead of
+	 *  being slewed by the loop, used when acquiring lock. */
+	#if !defined(SOFCLOCK_CAPTURE_THRESHOLD_NS)
+		#define SOFCLOCK_CAPTURE_THRESHOLD_NS  50000
+	#endif
+
+	/** Number of consecutive frames below \ref SOFCLOCK_LOCK_THRESHOLD_NS needed to report lock. */
+	#if !defined(SOFCLOCK_LOCK_FRAMES)
+		#define SOFCLOCK_LOCK_FRAMES           64
+	#endif
+
+	/** Number of timer periods without a SOF after which the loop is reported unlocked. */
+	#if !defined(SOFCLOCK_HOLDOVER_FRAMES)
+		#define SOFCLOCK_HOLDOVER_FRAMES       8
+	#endif
+
+	/** Proportional gain of the loop, as a right shift of the phase error (1/8). */
+	#if !defined(SOFCLOCK_KP_SHIFT)
+		#define SOFCLOCK_KP_SHIFT              3
+	#endif
+
+	/** Integral gain of the loop, as a right shift of the phase error (1/128). */
+	#if !defined(SOFCLOCK_KI_SHIFT)
+		#define SOFCLOCK_KI_SHIFT              7
+	#endif
+
+	/** Largest frequency correction the loop may apply, in parts per million. */
+	#if !defined(SOFCLOCK_MAX_TRIM_PPM)
+		#define SOFCLOCK_MAX_TRIM_PPM          1000
+	#endif
+
+/*******************************************************************************
+ *                     ESTRUTURAS E DEFINICOES DE TIPOS						   *
+ ******************************************************************************/
+/** Function called from the timer interrupt on every sampling tick. */
+typedef void (*SOFClock_SampleCallback_t)(void);
+
+/** Snapshot of the loop state, as returned by \ref SOFClock_GetStatus(). */
+typedef struct
+{
+	bool     Locked;             /**< True when the sampling clock is locked to the SOF. */
+	int32_t  PhaseErrorNs;       /**< Last measured phase error; positive when the timer period ended before the SOF. */
+	int32_t  FrequencyOffsetPpb; /**< Period trim applied by the loop; positive when the local clock runs fast. */
+} SOFClock_Status_t;
+
+/*******************************************************************************
+ *                       VARIAVEIS PUBLICAS (Globais)						   *
+ ******************************************************************************/
+
+/*******************************************************************************
+ *                      PROTOTIPOS DAS FUNCOES PUBLICAS						   *
+ ******************************************************************************/
+/** Starts TIMER0 with a nominal period of one frame and enables its interrupt.
+ *
+ *  \param[in] SampleCallback  Function called on every sampling tick, or NULL.
+ */
+void SOFClock_Init(SOFClock_SampleCallback_t SampleCallback);
+
+/** Measures the phase of the SOF just received and trims the timer period. Must be called
+ *  from \c EVENT_USB_Device_StartOfFrame(), i.e. from the USB interrupt.
+ */
+void SOFClock_SOF(void);
+
+/** Returns a consistent snapshot of the loop state.
+ *
+ *  \param[out] Status  Structure receiving the lock status, phase error and frequency offset.
+ */
+void SOFClock_GetStatus(SOFClock_Status_t* const Status);
+
+/*******************************************************************************
+ *                                   EOF									   *
+ ******************************************************************************/
+#endif
@@ -196,6 +196,14 @@
 				#define MIN(x, y)               (((x) < (y)) ? (x) : (y))
 			#endif
 			
+			/** Fails the build if a compile time condition does not hold, for checks on constants such as descriptor
+			 *  sizes that cannot be made with the preprocessor. Usable at file scope.
+			 *
+			 *  \param[in] Condition  Constant expression which must be non-zero.
+			 *  \param[in] Name       Identifier naming the check, reported by the compiler if it fails.
+			 */
+			#define STATIC_ASSERT(Condition, Name)  typedef char STATIC_ASSERT_##Name[(Condition) ? 1 : -1]
+
 			#if !defined(STRINGIFY) || defined(__DOXYGEN__)
 				/** Converts the given input into a string, via the C Preprocessor. This macro puts literal quotation
 				 *  marks around the input, converting the source into a string literal.
@@ -491,6 +491,16 @@
 				HID_RI_END_COLLECTION(0),                   \
 			HID_RI_END_COLLECTION(0)
 
+		/** Size in bits of each data field of a report described by \ref HID_DESCRIPTOR_VENDOR(). */
+		#define HID_VENDOR_REPORT_FIELD_BITS           8
+
+		/** Bit offset of a given data byte within a report described by \ref HID_DESCRIPTOR_VENDOR(), for use with
+		 *  \ref USB_GetHIDReportField() and \ref USB_SetHIDReportField().
+		 *
+		 *  \param[in] Index  Index of the data byte within the report.
+		 */
+		#define HID_VENDOR_REPORT_FIELD_OFFSET(Index)  ((Index) * HID_VENDOR_REPORT_FIELD_BITS)
+
 		/** \hideinitializer
 		 *  A list of HID report item array elements that describe a typical Vendor Defined byte array HID report descriptor,
 		 *  used for transporting arbitrary data between the USB host and device via HID reports. The resulting report should be
@@ -34,24 +34,354 @@
 #define  __INCLUDE_FROM_HID_DRIVER
 #include "HIDParser.h"
 
-uint8_t USB_ProcessHIDReport(const uint8_t* ReportData,
-                             uint16_t ReportSize,
-                             HID_ReportInfo_t* const ParserData)
+#if defined(HID_PARSER_ARENA)
+	#define HID_LIMIT_REPORTITEMS(ParserData)  ((ParserData)->MaxReportItems)
+	#define HID_LIMIT_COLLECTIONS(ParserData)  ((ParserData)->MaxCollections)
+	#define HID_LIMIT_REPORT_IDS(ParserData)   ((ParserData)->MaxReportIDs)
+	#define HID_LIMIT_ID_LOOKUP(ParserData)    ((ParserData)->ReportIDLookupSize)
+#else
+	#define HID_LIMIT_REPORTITEMS(ParserData)  HID_MAX_REPORTITEMS
+	#define HID_LIMIT_COLLECTIONS(ParserData)  HID_MAX_COLLECTIONS
+	#define HID_LIMIT_REPORT_IDS(ParserData)   HID_MAX_REPORT_IDS
+	#define HID_LIMIT_ID_LOOKUP(ParserData)    256
+#endif
+
+static inline uint8_t HID_LookupReportID(const HID_ReportInfo_t* const ParserData,
+                                         const uint8_t ReportID)
+{
+#if defined(HID_PARSER_ARENA)
+	/* Only an arena lookup table can be shorter than the 256 report IDs */
+	if (ReportID >= HID_LIMIT_ID_LOOKUP(ParserData))
+	  return 0;
+#endif
+
+	return ParserData->ReportIDLookup[ReportID];
+}
+
+static inline uint32_t HID_ItemIndexKey(const uint16_t UsagePage,
+                                        const uint16_t Usage)
+{
+	return (((uint32_t)UsagePage << 16) | Usage);
+}
+
+static inline uint16_t HID_ItemIndexSubKey(const uint8_t ReportID,
+                                           const uint8_t ItemType)
+{
+	return (((uint16_t)ReportID << 8) | ItemType);
+}
+
+static int8_t HID_CompareIndexedItem(const HID_ReportItem_t* const ReportItem,
+                                     const uint32_t Key,
+                                     const uint16_t SubKey)
+{
+	uint32_t ItemKey    = HID_ItemIndexKey(ReportItem->Attributes.Usage.Page, ReportItem->Attributes.Usage.Usage);
+	uint16_t ItemSubKey = HID_ItemIndexSubKey(ReportItem->ReportID, ReportItem->ItemType);
+
+	if (ItemKey != Key)
+	  return (ItemKey < Key) ? -1 : 1;
+
+	if (ItemSubKey != SubKey)
+	  return (ItemSubKey < SubKey) ? -1 : 1;
+
+	return 0;
+}
+
+static void HID_BuildItemIndex(HID_ReportInfo_t* const ParserData)
 {
-	HID_StateTable_t      StateTable[HID_STATETABLE_STACK_DEPTH];
-	HID_StateTable_t*     CurrStateTable          = &StateTable[0];
-	HID_CollectionPath_t* CurrCollectionPath      = NULL;
-	HID_ReportSizeInfo_t* CurrReportIDInfo        = &ParserData->ReportIDSizes[0];
-	uint16_t              UsageList[HID_USAGE_STACK_DEPTH];
-	uint8_t               UsageListSize           = 0;
-	HID_MinMax_t          UsageMinMax             = {0, 0};
-
-	memset(ParserData,       0x00, sizeof(HID_ReportInfo_t));
-	memset(CurrStateTable,   0x00, sizeof(HID_StateTable_t));
-	memset(CurrReportIDInfo, 0x00, sizeof(HID_ReportSizeInfo_t));
+	uint8_t* ItemIndex = ParserData->ItemIndex;
+
+	uint8_t i;
+	for (i = 0; i < ParserData->TotalReportItems; i++)
+	{
+		HID_ReportItem_t* ReportItem = &ParserData->ReportItems[i];
+		uint32_t          Key        = HID_ItemIndexKey(ReportItem->Attributes.Usage.Page, ReportItem->Attributes.Usage.Usage);
+		uint16_t          SubKey     = HID_ItemIndexSubKey(ReportItem->ReportID, ReportItem->ItemType);
+		uint8_t           Pos        = i;
+
+		/* Insertion sort, stable so that duplicate usages stay in descriptor order */
+		while (Pos && (HID_CompareIndexedItem(&ParserData->ReportItems[ItemIndex[Pos - 1]], Key, SubKey) > 0))
+		{
+			ItemIndex[Pos] = ItemIndex[Pos - 1];
+			Pos--;
+		}
+
+		ItemIndex[Pos] = i;
+	}
+}
+
+static void HID_BeginParse(HID_ParserContext_t* const Context,
+                           HID_ReportInfo_t* const ParserData,
+                           HID_StateTable_t* const StateTable,
+                           const uint8_t StateTableDepth,
+                           uint16_t* const UsageList,
+                           const uint8_t UsageListDepth)
+{
+	Context->ParserData          = ParserData;
+	Context->StateTable          = StateTable;
+	Context->StateTableDepth     = StateTableDepth;
+	Context->CurrStateTable      = &StateTable[0];
+	Context->CurrCollectionPath  = NULL;
+	Context->CurrReportIDInfo    = &ParserData->ReportIDSizes[0];
+	Context->UsageList           = UsageList;
+	Context->UsageListDepth      = UsageListDepth;
+	Context->UsageListSize       = 0;
+	Context->UsageMinMax.Minimum = 0;
+	Context->UsageMinMax.Maximum = 0;
+
+	memset(Context->CurrStateTable,   0x00, sizeof(HID_StateTable_t));
+	memset(Context->CurrReportIDInfo, 0x00, sizeof(HID_ReportSizeInfo_t));
 
 	ParserData->TotalDeviceReports = 1;
 
+	memset(ParserData->ReportIDLookup, 0x00, HID_LIMIT_ID_LOOKUP(ParserData));
+	ParserData->ReportIDLookup[0] = 1;
+}
+
+static uint8_t HID_ParseItem(HID_ParserContext_t* const Context,
+                             const uint8_t HIDReportItem,
+                             const uint32_t ReportItemData)
+{
+	HID_ReportInfo_t* ParserData = Context->ParserData;
+
+	uint8_t ReportItemNum;
+	switch (HIDReportItem & (HID_RI_TYPE_MASK | HID_RI_TAG_MASK))
+	{
+		case HID_RI_PUSH(0):
+			if (Context->CurrStateTable == &Context->StateTable[Context->StateTableDepth - 1])
+			  return HID_PARSE_HIDStackOverflow;
+
+			memcpy((Context->CurrStateTable + 1),
+			       Context->CurrStateTable,
+			       sizeof(HID_StateTable_t));
+
+			Context->CurrStateTable++;
+			break;
+		case HID_RI_POP(0):
+			if (Context->CurrStateTable == &Context->StateTable[0])
+			  return HID_PARSE_HIDStackUnderflow;
+
+			Context->CurrStateTable--;
+			break;
+		case HID_RI_USAGE_PAGE(0):
+			if ((HIDReportItem & HID_RI_DATA_SIZE_MASK) == HID_RI_DATA_BITS_32)
+			  Context->CurrStateTable->Attributes.Usage.Page = (ReportItemData >> 16);
+			
+			Context->CurrStateTable->Attributes.Usage.Page       = ReportItemData;
+			break;
+		case HID_RI_LOGICAL_MINIMUM(0):
+			Context->CurrStateTable->Attributes.Logical.Minimum  = ReportItemData;
+			break;
+		case HID_RI_LOGICAL_MAXIMUM(0):
+			Context->CurrStateTable->Attributes.Logical.Maximum  = ReportItemData;
+			break;
+		case HID_RI_PHYSICAL_MINIMUM(0):
+			Context->CurrStateTable->Attributes.Physical.Minimum = ReportItemData;
+			break;
+		case HID_RI_PHYSICAL_MAXIMUM(0):
+			Context->CurrStateTable->Attributes.Physical.Maximum = ReportItemData;
+			break;
+		case HID_RI_UNIT_EXPONENT(0):
+			Context->CurrStateTable->Attributes.Unit.Exponent    = ReportItemData;
+			break;
+		case HID_RI_UNIT(0):
+			Context->CurrStateTable->Attributes.Unit.Type        = ReportItemData;
+			break;
+		case HID_RI_REPORT_SIZE(0):
+			Context->CurrStateTable->Attributes.BitSize          = ReportItemData;
+			break;
+		case HID_RI_REPORT_COUNT(0):
+			Context->CurrStateTable->ReportCount                 = ReportItemData;
+			break;
+		case HID_RI_REPORT_ID(0):
+			Context->CurrStateTable->ReportID                    = ReportItemData;
+
+			if (ParserData->UsingReportIDs)
+			{
+				uint8_t ReportIndex = HID_LookupReportID(ParserData, Context->CurrStateTable->ReportID);
+
+				if (ReportIndex)
+				{
+					Context->CurrReportIDInfo = &ParserData->ReportIDSizes[ReportIndex - 1];
+				}
+				else
+				{
+					if (ParserData->TotalDeviceReports == HID_LIMIT_REPORT_IDS(ParserData))
+					  return HID_PARSE_InsufficientReportIDItems;
+
+					Context->CurrReportIDInfo = &ParserData->ReportIDSizes[ParserData->TotalDeviceReports++];
+					memset(Context->CurrReportIDInfo, 0x00, sizeof(HID_ReportSizeInfo_t));
+				}
+			}
+			else
+			{
+				/* The first report ID takes over the entry created for report ID 0 */
+				ParserData->ReportIDLookup[0] = 0;
+			}
+
+			ParserData->UsingReportIDs = true;
+
+			Context->CurrReportIDInfo->ReportID = Context->CurrStateTable->ReportID;
+
+#if defined(HID_PARSER_ARENA)
+			if (Context->CurrStateTable->ReportID < HID_LIMIT_ID_LOOKUP(ParserData))
+#endif
+			{
+				ParserData->ReportIDLookup[Context->CurrStateTable->ReportID] =
+				    (Context->CurrReportIDInfo - ParserData->ReportIDSizes) + 1;
+			}
+			break;
+		case HID_RI_USAGE(0):
+			if (Context->UsageListSize == Context->UsageListDepth)
+			  return HID_PARSE_UsageListOverflow;
+
+			Context->UsageList[Context->UsageListSize++] = ReportItemData;
+			break;
+		case HID_RI_USAGE_MINIMUM(0):
+			Context->UsageMinMax.Minimum = ReportItemData;
+			break;
+		case HID_RI_USAGE_MAXIMUM(0):
+			Context->UsageMinMax.Maximum = ReportItemData;
+			break;
+		case HID_RI_COLLECTION(0):
+			if (Context->CurrCollectionPath == NULL)
+			{
+				Context->CurrCollectionPath = &ParserData->CollectionPaths[0];
+			}
+			else
+			{
+				HID_CollectionPath_t* ParentCollectionPath = Context->CurrCollectionPath;
+
+				Context->CurrCollectionPath = &ParserData->CollectionPaths[1];
+
+				while (Context->CurrCollectionPath->Parent != NULL)
+				{
+					if (Context->CurrCollectionPath == &ParserData->CollectionPaths[HID_LIMIT_COLLECTIONS(ParserData) - 1])
+					  return HID_PARSE_InsufficientCollectionPaths;
+
+					Context->CurrCollectionPath++;
+				}
+
+				Context->CurrCollectionPath->Parent = ParentCollectionPath;
+			}
+
+			Context->CurrCollectionPath->Type       = ReportItemData;
+			Context->CurrCollectionPath->Usage.Page = Context->CurrStateTable->Attributes.Usage.Page;
+
+			if (Context->UsageListSize)
+			{
+				Context->CurrCollectionPath->Usage.Usage = Context->UsageList[0];
+				uint8_t i;
+				for (i = 0; i < Context->UsageListSize; i++)
+				  Context->UsageList[i] = Context->UsageList[i + 1];
+
+				Context->UsageListSize--;
+			}
+			else if (Context->UsageMinMax.Minimum <= Context->UsageMinMax.Maximum)
+			{
+				Context->CurrCollectionPath->Usage.Usage = Context->UsageMinMax.Minimum++;
+			}
+
+			break;
+		case HID_RI_END_COLLECTION(0):
+			if (Context->CurrCollectionPath == NULL)
+			  return HID_PARSE_UnexpectedEndCollection;
+
+			Context->CurrCollectionPath = Context->CurrCollectionPath->Parent;
+			break;
+		case HID_RI_INPUT(0):
+		case HID_RI_OUTPUT(0):
+		case HID_RI_FEATURE(0):
+			for (ReportItemNum = 0; ReportItemNum < Context->CurrStateTable->ReportCount; ReportItemNum++)
+			{
+				HID_ReportItem_t NewReportItem;
+
+				memcpy(&NewReportItem.Attributes,
+				       &Context->CurrStateTable->Attributes,
+				       sizeof(HID_ReportItem_Attributes_t));
+
+				NewReportItem.ItemFlags      = ReportItemData;
+				NewReportItem.CollectionPath = Context->CurrCollectionPath;
+				NewReportItem.ReportID       = Context->CurrStateTable->ReportID;
+
+				if (Context->UsageListSize)
+				{
+					NewReportItem.Attributes.Usage.Usage = Context->UsageList[0];
+					uint8_t i;
+					for (i = 0; i < Context->UsageListSize; i++)
+					  Context->UsageList[i] = Context->UsageList[i + 1];
+
+					Context->UsageListSize--;
+				}
+				else if (Context->UsageMinMax.Minimum <= Context->UsageMinMax.Maximum)
+				{
+					NewReportItem.Attributes.Usage.Usage = Context->UsageMinMax.Minimum++;
+				}
+
+				uint8_t ItemTypeTag = (HIDReportItem & (HID_RI_TYPE_MASK | HID_RI_TAG_MASK));
+
+				if (ItemTypeTag == HID_RI_INPUT(0))
+				  NewReportItem.ItemType = HID_REPORT_ITEM_In;
+				else if (ItemTypeTag == HID_RI_OUTPUT(0))
+				  NewReportItem.ItemType = HID_REPORT_ITEM_Out;
+				else
+				  NewReportItem.ItemType = HID_REPORT_ITEM_Feature;
+
+				NewReportItem.BitOffset = Context->CurrReportIDInfo->ReportSizeBits[NewReportItem.ItemType];
+				USB_PrepareHIDReportItem(&NewReportItem);
+
+				Context->CurrReportIDInfo->ReportSizeBits[NewReportItem.ItemType] += Context->CurrStateTable->Attributes.BitSize;
+
+				if (ParserData->LargestReportSizeBits < NewReportItem.BitOffset)
+				  ParserData->LargestReportSizeBits = NewReportItem.BitOffset;
+
+				if (ParserData->TotalReportItems == HID_LIMIT_REPORTITEMS(ParserData))
+				  return HID_PARSE_InsufficientReportItems;
+
+				memcpy(&ParserData->ReportItems[ParserData->TotalReportItems],
+				       &NewReportItem, sizeof(HID_ReportItem_t));
+
+				if (!(ReportItemData & HID_IOF_CONSTANT) && CALLBACK_HIDParser_FilterHIDReportItem(&NewReportItem))
+				  ParserData->TotalReportItems++;
+			}
+
+			break;
+	}
+
+	if ((HIDReportItem & HID_RI_TYPE_MASK) == HID_RI_TYPE_MAIN)
+	{
+		Context->UsageMinMax.Minimum = 0;
+		Context->UsageMinMax.Maximum = 0;
+		Context->UsageListSize       = 0;
+	}
+
+	return HID_PARSE_Successful;
+}
+
+static uint8_t HID_EndParse(HID_ParserContext_t* const Context)
+{
+	HID_ReportInfo_t* ParserData = Context->ParserData;
+
+	if (!(ParserData->TotalReportItems))
+	  return HID_PARSE_NoUnfilteredReportItems;
+
+	HID_BuildItemIndex(ParserData);
+
+	return HID_PARSE_Successful;
+}
+
+static uint8_t HID_ParseReport(const uint8_t* ReportData,
+                               uint16_t ReportSize,
+                               HID_ReportInfo_t* const ParserData,
+                               HID_StateTable_t* const StateTable,
+                               const uint8_t StateTableDepth,
+                               uint16_t* const UsageList,
+                               const uint8_t UsageListDepth)
+{
+	HID_ParserContext_t Context;
+	uint8_t             ErrorCode;
+
+	HID_BeginParse(&Context, ParserData, StateTable, StateTableDepth, UsageList, UsageListDepth);
+
 	while (ReportSize)
 	{
 		uint8_t  HIDReportItem  = *ReportData;
@@ -79,214 +409,372 @@ uint8_t USB_ProcessHIDReport(const uint8_t* ReportData,
 				break;
 		}
 
-		uint8_t ReportItemNum;
+		if ((ErrorCode = HID_ParseItem(&Context, HIDReportItem, ReportItemData)) != HID_PARSE_Successful)
+		  return ErrorCode;
+	}
+
+	return HID_EndParse(&Context);
+}
+
+uint32_t USB_GetHIDReportDescriptorHash(const uint8_t* ReportData,
+                                        uint16_t ReportSize)
+{
+	uint32_t Hash = 0x811C9DC5;
+
+	while (ReportSize--)
+	{
+		Hash ^= *(ReportData++);
+		Hash *= 0x01000193;
+	}
+
+	return Hash;
+}
+
+#if !defined(HID_PARSER_ARENA)
+uint8_t USB_ProcessHIDReport(const uint8_t* ReportData,
+                             uint16_t ReportSize,
+                             HID_ReportInfo_t* const ParserData)
+{
+	HID_StateTable_t StateTable[HID_STATETABLE_STACK_DEPTH];
+	uint16_t         UsageList[HID_USAGE_STACK_DEPTH];
+
+	memset(ParserData, 0x00, sizeof(HID_ReportInfo_t));
+
+	return HID_ParseReport(ReportData, ReportSize, ParserData,
+	                       StateTable, HID_STATETABLE_STACK_DEPTH, UsageList, HID_USAGE_STACK_DEPTH);
+}
+
+void USB_InitHIDReportParser(HID_ReportParser_t* const Parser,
+                             HID_ReportInfo_t* const ParserData)
+{
+	memset(ParserData, 0x00, sizeof(HID_ReportInfo_t));
+
+	HID_BeginParse(&Parser->Context, ParserData, Parser->StateTable, HID_STATETABLE_STACK_DEPTH,
+	               Parser->UsageList, HID_USAGE_STACK_DEPTH);
+
+	Parser->ItemBufferSize = 0;
+	Parser->ErrorCode      = HID_PARSE_Successful;
+}
+
+uint8_t USB_ProcessHIDReportChunk(HID_ReportParser_t* const Parser,
+                                  const uint8_t* ChunkData,
+                                  uint16_t ChunkSize)
+{
+	while (ChunkSize && (Parser->ErrorCode == HID_PARSE_Successful))
+	{
+		uint8_t ItemSize;
+
+		Parser->ItemBuffer[Parser->ItemBufferSize++] = *(ChunkData++);
+		ChunkSize--;
+
+		ItemSize = (Parser->ItemBuffer[0] & HID_RI_DATA_SIZE_MASK);
+
+		if (ItemSize == HID_RI_DATA_BITS_32)
+		  ItemSize = 4;
+
+		/* Items are only parsed once all of their data bytes have arrived, which may take several chunks */
+		if (Parser->ItemBufferSize < (ItemSize + 1))
+		  continue;
+
+		uint32_t ReportItemData = 0;
+
+		while (ItemSize)
+		{
+			ReportItemData = (ReportItemData << 8) | Parser->ItemBuffer[ItemSize];
+			ItemSize--;
+		}
+
+		Parser->ItemBufferSize = 0;
+		Parser->ErrorCode      = HID_ParseItem(&Parser->Context, Parser->ItemBuffer[0], ReportItemData);
+	}
+
+	return Parser->ErrorCode;
+}
+
+uint8_t USB_FinishHIDReportParser(HID_ReportParser_t* const Parser)
+{
+	if (Parser->ErrorCode != HID_PARSE_Successful)
+	  return Parser->ErrorCode;
+
+	if (Parser->ItemBufferSize)
+	  return HID_PARSE_TruncatedItem;
+
+	return HID_EndParse(&Parser->Context);
+}
+
+void USB_CopyHIDReportInfo(HID_ReportInfo_t* const Dest,
+                           const HID_ReportInfo_t* const Source)
+{
+	const HID_CollectionPath_t* SourcePaths = Source->CollectionPaths;
+
+	memcpy(Dest, Source, sizeof(HID_ReportInfo_t));
+
+	/* Collection paths are referenced by pointer, rebase them onto the copy's own table */
+	uint8_t i;
+	for (i = 0; i < Dest->TotalReportItems; i++)
+	{
+		if (Dest->ReportItems[i].CollectionPath != NULL)
+		  Dest->ReportItems[i].CollectionPath = &Dest->CollectionPaths[Source->ReportItems[i].CollectionPath - SourcePaths];
+	}
+
+	for (i = 0; i < HID_MAX_COLLECTIONS; i++)
+	{
+		if (Dest->CollectionPaths[i].Parent != NULL)
+		  Dest->CollectionPaths[i].Parent = &Dest->CollectionPaths[Source->CollectionPaths[i].Parent - SourcePaths];
+	}
+}
+#else
+#define HID_ARENA_ALIGN(Size)        (((Size) + 3) & ~3)
+#define HID_ARENA_COUNT_STACK_DEPTH  8
+
+static uint16_t HID_ArenaSize(const HID_ArenaLimits_t* const Limits)
+{
+	return (HID_ARENA_ALIGN(Limits->ReportItems * sizeof(HID_ReportItem_t))     +
+	        HID_ARENA_ALIGN(Limits->ReportItems * sizeof(uint8_t))              +
+	        HID_ARENA_ALIGN(Limits->Collections * sizeof(HID_CollectionPath_t)) +
+	        HID_ARENA_ALIGN(Limits->ReportIDs   * sizeof(HID_ReportSizeInfo_t)) +
+	        HID_ARENA_ALIGN(Limits->HighestReportID + 1)                        +
+	        HID_ARENA_ALIGN(Limits->StackDepth  * sizeof(HID_StateTable_t))     +
+	        HID_ARENA_ALIGN((Limits->UsageDepth + 1) * sizeof(uint16_t)));
+}
+
+uint16_t USB_GetHIDReportArenaSize(const uint8_t* ReportData,
+                                   uint16_t ReportSize,
+                                   HID_ArenaLimits_t* const Limits)
+{
+	uint8_t  ReportIDMap[256 / 8];
+	uint8_t  ReportCountStack[HID_ARENA_COUNT_STACK_DEPTH];
+	uint8_t  ReportCount   = 0;
+	uint8_t  MaxReportCount = 0;
+	uint8_t  StackDepth    = 0;
+	uint8_t  UsageRun      = 0;
+	uint16_t DataItems     = 0;
+	bool     HasConstItems = false;
+
+	memset(Limits,      0x00, sizeof(HID_ArenaLimits_t));
+	memset(ReportIDMap, 0x00, sizeof(ReportIDMap));
+
+	Limits->ReportIDs  = 1;
+	Limits->StackDepth = 1;
+
+	while (ReportSize)
+	{
+		uint8_t  HIDReportItem  = *ReportData;
+		uint32_t ReportItemData = 0;
+		uint8_t  DataSize       = (HIDReportItem & HID_RI_DATA_SIZE_MASK);
+
+		if (DataSize == HID_RI_DATA_BITS_32)
+		  DataSize = 4;
+
+		ReportData++;
+		ReportSize--;
+
+		if (DataSize > ReportSize)
+		  break;
+
+		uint8_t i;
+		for (i = 0; i < DataSize; i++)
+		  ReportItemData |= ((uint32_t)ReportData[i] << (8 * i));
+
+		ReportData += DataSize;
+		ReportSize -= DataSize;
+
 		switch (HIDReportItem & (HID_RI_TYPE_MASK | HID_RI_TAG_MASK))
 		{
 			case HID_RI_PUSH(0):
-				if (CurrStateTable == &StateTable[HID_STATETABLE_STACK_DEPTH - 1])
-				  return HID_PARSE_HIDStackOverflow;
-
-				memcpy((CurrStateTable + 1),
-				       CurrStateTable,
-				       sizeof(HID_ReportItem_t));
+				if (StackDepth < HID_ARENA_COUNT_STACK_DEPTH)
+				  ReportCountStack[StackDepth] = ReportCount;
 
-				CurrStateTable++;
+				if (++StackDepth >= Limits->StackDepth)
+				  Limits->StackDepth = (StackDepth + 1);
 				break;
 			case HID_RI_POP(0):
-				if (CurrStateTable == &StateTable[0])
-				  return HID_PARSE_HIDStackUnderflow;
+				if (StackDepth)
+				  StackDepth--;
 
-				CurrStateTable--;
-				break;
-			case HID_RI_USAGE_PAGE(0):
-				if ((HIDReportItem & HID_RI_DATA_SIZE_MASK) == HID_RI_DATA_BITS_32)
-				  CurrStateTable->Attributes.Usage.Page = (ReportItemData >> 16);
-				
-				CurrStateTable->Attributes.Usage.Page       = ReportItemData;
-				break;
-			case HID_RI_LOGICAL_MINIMUM(0):
-				CurrStateTable->Attributes.Logical.Minimum  = ReportItemData;
+				ReportCount = (StackDepth < HID_ARENA_COUNT_STACK_DEPTH) ? ReportCountStack[StackDepth] : MaxReportCount;
 				break;
-			case HID_RI_LOGICAL_MAXIMUM(0):
-				CurrStateTable->Attributes.Logical.Maximum  = ReportItemData;
-				break;
-			case HID_RI_PHYSICAL_MINIMUM(0):
-				CurrStateTable->Attributes.Physical.Minimum = ReportItemData;
-				break;
-			case HID_RI_PHYSICAL_MAXIMUM(0):
-				CurrStateTable->Attributes.Physical.Maximum = ReportItemData;
+			case HID_RI_REPORT_COUNT(0):
+				ReportCount = ReportItemData;
+
+				if (ReportCount > MaxReportCount)
+				  MaxReportCount = ReportCount;
 				break;
-			case HID_RI_UNIT_EXPONENT(0):
-				CurrStateTable->Attributes.Unit.Exponent    = ReportItemData;
+			case HID_RI_REPORT_ID(0):
+				ReportIDMap[(uint8_t)ReportItemData >> 3] |= (1 << (ReportItemData & 0x07));
 				break;
-			case HID_RI_UNIT(0):
-				CurrStateTable->Attributes.Unit.Type        = ReportItemData;
+			case HID_RI_USAGE(0):
+				if (++UsageRun > Limits->UsageDepth)
+				  Limits->UsageDepth = UsageRun;
 				break;
-			case HID_RI_REPORT_SIZE(0):
-				CurrStateTable->Attributes.BitSize          = ReportItemData;
+			case HID_RI_COLLECTION(0):
+				if (Limits->Collections < 0xFF)
+				  Limits->Collections++;
 				break;
-			case HID_RI_REPORT_COUNT(0):
-				CurrStateTable->ReportCount                 = ReportItemData;
+			case HID_RI_INPUT(0):
+			case HID_RI_OUTPUT(0):
+			case HID_RI_FEATURE(0):
+				if (ReportItemData & HID_IOF_CONSTANT)
+				  HasConstItems = true;
+				else
+				  DataItems += ReportCount;
 				break;
-			case HID_RI_REPORT_ID(0):
-				CurrStateTable->ReportID                    = ReportItemData;
-
-				if (ParserData->UsingReportIDs)
-				{
-					CurrReportIDInfo = NULL;
+		}
 
-					uint8_t i;
-					for (i = 0; i < ParserData->TotalDeviceReports; i++)
-					{
-						if (ParserData->ReportIDSizes[i].ReportID == CurrStateTable->ReportID)
-						{
-							CurrReportIDInfo = &ParserData->ReportIDSizes[i];
-							break;
-						}
-					}
-
-					if (CurrReportIDInfo == NULL)
-					{
-						if (ParserData->TotalDeviceReports == HID_MAX_REPORT_IDS)
-						  return HID_PARSE_InsufficientReportIDItems;
-
-						CurrReportIDInfo = &ParserData->ReportIDSizes[ParserData->TotalDeviceReports++];
-						memset(CurrReportIDInfo, 0x00, sizeof(HID_ReportSizeInfo_t));
-					}
-				}
+		if ((HIDReportItem & HID_RI_TYPE_MASK) == HID_RI_TYPE_MAIN)
+		  UsageRun = 0;
+	}
 
-				ParserData->UsingReportIDs = true;
+	uint8_t i;
+	uint8_t ReportIDs = 0;
+	for (i = 0; i < sizeof(ReportIDMap); i++)
+	{
+		uint8_t Bits = ReportIDMap[i];
 
-				CurrReportIDInfo->ReportID = CurrStateTable->ReportID;
-				break;
-			case HID_RI_USAGE(0):
-				if (UsageListSize == HID_USAGE_STACK_DEPTH)
-				  return HID_PARSE_UsageListOverflow;
+		if (Bits)
+		{
+			uint8_t TopBit = 7;
 
-				UsageList[UsageListSize++] = ReportItemData;
-				break;
-			case HID_RI_USAGE_MINIMUM(0):
-				UsageMinMax.Minimum = ReportItemData;
-				break;
-			case HID_RI_USAGE_MAXIMUM(0):
-				UsageMinMax.Maximum = ReportItemData;
-				break;
-			case HID_RI_COLLECTION(0):
-				if (CurrCollectionPath == NULL)
-				{
-					CurrCollectionPath = &ParserData->CollectionPaths[0];
-				}
-				else
-				{
-					HID_CollectionPath_t* ParentCollectionPath = CurrCollectionPath;
+			while (!(Bits & (1 << TopBit)))
+			  TopBit--;
 
-					CurrCollectionPath = &ParserData->CollectionPaths[1];
+			Limits->HighestReportID = (i << 3) + TopBit;
+		}
 
-					while (CurrCollectionPath->Parent != NULL)
-					{
-						if (CurrCollectionPath == &ParserData->CollectionPaths[HID_MAX_COLLECTIONS - 1])
-						  return HID_PARSE_InsufficientCollectionPaths;
+		while (Bits)
+		{
+			ReportIDs++;
+			Bits &= (Bits - 1);
+		}
+	}
 
-						CurrCollectionPath++;
-					}
+	if (ReportIDs > Limits->ReportIDs)
+	  Limits->ReportIDs = ReportIDs;
 
-					CurrCollectionPath->Parent = ParentCollectionPath;
-				}
+	/* Constant items are briefly stored before being discarded, so need one spare slot */
+	DataItems += (HasConstItems ? 1 : 0);
+	Limits->ReportItems = (DataItems > 0xFF) ? 0xFF : DataItems;
 
-				CurrCollectionPath->Type       = ReportItemData;
-				CurrCollectionPath->Usage.Page = CurrStateTable->Attributes.Usage.Page;
+	if (!(Limits->UsageDepth))
+	  Limits->UsageDepth = 1;
 
-				if (UsageListSize)
-				{
-					CurrCollectionPath->Usage.Usage = UsageList[0];
-					uint8_t i;
-					for (i = 0; i < UsageListSize; i++)
-					  UsageList[i] = UsageList[i + 1];
+	return HID_ArenaSize(Limits);
+}
 
-					UsageListSize--;
-				}
-				else if (UsageMinMax.Minimum <= UsageMinMax.Maximum)
-				{
-					CurrCollectionPath->Usage.Usage = UsageMinMax.Minimum++;
-				}
+uint8_t USB_ProcessHIDReportArena(const uint8_t* ReportData,
+                                  uint16_t ReportSize,
+                                  HID_ReportInfo_t* const ParserData,
+                                  void* Arena,
+                                  const uint16_t ArenaSize)
+{
+	HID_ArenaLimits_t Limits;
+	uint8_t*          ArenaPos = (uint8_t*)Arena;
 
-				break;
-			case HID_RI_END_COLLECTION(0):
-				if (CurrCollectionPath == NULL)
-				  return HID_PARSE_UnexpectedEndCollection;
+	if (USB_GetHIDReportArenaSize(ReportData, ReportSize, &Limits) > ArenaSize)
+	  return HID_PARSE_InsufficientArena;
 
-				CurrCollectionPath = CurrCollectionPath->Parent;
-				break;
-			case HID_RI_INPUT(0):
-			case HID_RI_OUTPUT(0):
-			case HID_RI_FEATURE(0):
-				for (ReportItemNum = 0; ReportItemNum < CurrStateTable->ReportCount; ReportItemNum++)
-				{
-					HID_ReportItem_t NewReportItem;
+	memset(ParserData, 0x00, sizeof(HID_ReportInfo_t));
 
-					memcpy(&NewReportItem.Attributes,
-					       &CurrStateTable->Attributes,
-					       sizeof(HID_ReportItem_Attributes_t));
+	ParserData->ReportItems     = (HID_ReportItem_t*)ArenaPos;
+	ArenaPos += HID_ARENA_ALIGN(Limits.ReportItems * sizeof(HID_ReportItem_t));
+	ParserData->ItemIndex       = ArenaPos;
+	ArenaPos += HID_ARENA_ALIGN(Limits.ReportItems * sizeof(uint8_t));
+	ParserData->CollectionPaths = (HID_CollectionPath_t*)ArenaPos;
+	ArenaPos += HID_ARENA_ALIGN(Limits.Collections * sizeof(HID_CollectionPath_t));
+	ParserData->ReportIDSizes   = (HID_ReportSizeInfo_t*)ArenaPos;
+	ArenaPos += HID_ARENA_ALIGN(Limits.ReportIDs * sizeof(HID_ReportSizeInfo_t));
+	ParserData->ReportIDLookup  = ArenaPos;
+	ArenaPos += HID_ARENA_ALIGN(Limits.HighestReportID + 1);
 
-					NewReportItem.ItemFlags      = ReportItemData;
-					NewReportItem.CollectionPath = CurrCollectionPath;
-					NewReportItem.ReportID       = CurrStateTable->ReportID;
+	ParserData->MaxReportItems  = Limits.ReportItems;
+	ParserData->MaxCollections  = Limits.Collections;
+	ParserData->MaxReportIDs    = Limits.ReportIDs;
+	ParserData->ReportIDLookupSize = (uint16_t)Limits.HighestReportID + 1;
 
-					if (UsageListSize)
-					{
-						NewReportItem.Attributes.Usage.Usage = UsageList[0];
-						uint8_t i;
-						for (i = 0; i < UsageListSize; i++)
-						  UsageList[i] = UsageList[i + 1];
+	memset(ParserData->CollectionPaths, 0x00, Limits.Collections * sizeof(HID_CollectionPath_t));
 
-						UsageListSize--;
-					}
-					else if (UsageMinMax.Minimum <= UsageMinMax.Maximum)
-					{
-						NewReportItem.Attributes.Usage.Usage = UsageMinMax.Minimum++;
-					}
+	HID_StateTable_t* StateTable = (HID_StateTable_t*)ArenaPos;
+	ArenaPos += HID_ARENA_ALIGN(Limits.StackDepth * sizeof(HID_StateTable_t));
 
-					uint8_t ItemTypeTag = (HIDReportItem & (HID_RI_TYPE_MASK | HID_RI_TAG_MASK));
+	return HID_ParseReport(ReportData, ReportSize, ParserData,
+	                       StateTable, Limits.StackDepth, (uint16_t*)ArenaPos, Limits.UsageDepth);
+}
+#endif
 
-					if (ItemTypeTag == HID_RI_INPUT(0))
-					  NewReportItem.ItemType = HID_REPORT_ITEM_In;
-					else if (ItemTypeTag == HID_RI_OUTPUT(0))
-					  NewReportItem.ItemType = HID_REPORT_ITEM_Out;
-					else
-					  NewReportItem.ItemType = HID_REPORT_ITEM_Feature;
+static inline uint32_t HID_ReadReportBits(const uint8_t* ReportData,
+                                          const HID_ReportItem_t* const ReportItem)
+{
+	const uint8_t* Data = &ReportData[ReportItem->ByteOffset];
+	uint32_t       Bits;
 
-					NewReportItem.BitOffset = CurrReportIDInfo->ReportSizeBits[NewReportItem.ItemType];
+	switch (ReportItem->ByteCount)
+	{
+		case 1:
+			Bits = Data[0];
+			break;
+		case 2:
+			Bits = (Data[0] | ((uint32_t)Data[1] << 8));
+			break;
+		case 3:
+			Bits = (Data[0] | ((uint32_t)Data[1] << 8) | ((uint32_t)Data[2] << 16));
+			break;
+		case 4:
+		case 5:
+			Bits = (Data[0] | ((uint32_t)Data[1] << 8) | ((uint32_t)Data[2] << 16) | ((uint32_t)Data[3] << 24));
+			break;
+		default:
+			/* A zero size item occupies no byte of the report, nothing may be read */
+			return 0;
+	}
 
-					CurrReportIDInfo->ReportSizeBits[NewReportItem.ItemType] += CurrStateTable->Attributes.BitSize;
+	Bits >>= ReportItem->BitShift;
 
-					if (ParserData->LargestReportSizeBits < NewReportItem.BitOffset)
-					  ParserData->LargestReportSizeBits = NewReportItem.BitOffset;
+	if (ReportItem->ByteCount == 5)
+	  Bits |= ((uint32_t)Data[4] << (32 - ReportItem->BitShift));
 
-					if (ParserData->TotalReportItems == HID_MAX_REPORTITEMS)
-					  return HID_PARSE_InsufficientReportItems;
+	return (Bits & ReportItem->BitMask);
+}
 
-					memcpy(&ParserData->ReportItems[ParserData->TotalReportItems],
-					       &NewReportItem, sizeof(HID_ReportItem_t));
+static inline void HID_WriteReportBits(uint8_t* ReportData,
+                                       const HID_ReportItem_t* const ReportItem)
+{
+	uint8_t* Data  = &ReportData[ReportItem->ByteOffset];
+	uint32_t Value = (ReportItem->Value & ReportItem->BitMask);
+	uint32_t Mask  = ReportItem->BitMask;
+	uint8_t  Shift = ReportItem->BitShift;
+	uint8_t  i;
 
-					if (!(ReportItemData & HID_IOF_CONSTANT) && CALLBACK_HIDParser_FilterHIDReportItem(&NewReportItem))
-					  ParserData->TotalReportItems++;
-				}
+	for (i = 0; i < ReportItem->ByteCount; i++)
+	{
+		uint32_t ByteValue;
+		uint32_t ByteMask;
 
-				break;
+		if (i == 0)
+		{
+			ByteValue = (Value << Shift);
+			ByteMask  = (Mask  << Shift);
 		}
-
-		if ((HIDReportItem & HID_RI_TYPE_MASK) == HID_RI_TYPE_MAIN)
+		else
 		{
-			UsageMinMax.Minimum = 0;
-			UsageMinMax.Maximum = 0;
-			UsageListSize       = 0;
+			ByteValue = (Value >> ((8 * i) - Shift));
+			ByteMask  = (Mask  >> ((8 * i) - Shift));
 		}
+
+		Data[i] = ((Data[i] & ~ByteMask) | (ByteValue & ByteMask));
 	}
+}
 
-	if (!(ParserData->TotalReportItems))
-	  return HID_PARSE_NoUnfilteredReportItems;
+void USB_PrepareHIDReportItem(HID_ReportItem_t* const ReportItem)
+{
+	uint8_t BitSize = ReportItem->Attributes.BitSize;
 
-	return HID_PARSE_Successful;
+	if (BitSize > 32)
+	  BitSize = 32;
+
+	ReportItem->ByteOffset = ((ReportItem->BitOffset >> 3) + (ReportItem->ReportID ? 1 : 0));
+	ReportItem->BitShift   = (ReportItem->BitOffset & 0x07);
+	ReportItem->ByteCount  = ((ReportItem->BitShift + BitSize + 7) >> 3);
+	ReportItem->BitMask    = (BitSize == 32) ? 0xFFFFFFFF : ((1UL << BitSize) - 1);
 }
 
 bool USB_GetHIDReportItemInfo(const uint8_t* ReportData,
@@ -295,31 +783,193 @@ bool USB_GetHIDReportItemInfo(const uint8_t* ReportData,
 	if (ReportItem == NULL)
 	  return false;
 
-	uint16_t DataBitsRem  = ReportItem->Attributes.BitSize;
-	uint16_t CurrentBit   = ReportItem->BitOffset;
-	uint32_t BitMask      = (1 << 0);
-
 	if (ReportItem->ReportID)
 	{
 		if (ReportItem->ReportID != ReportData[0])
 		  return false;
-
-		ReportData++;
 	}
 
 	ReportItem->PreviousValue = ReportItem->Value;
-	ReportItem->Value = 0;
+	ReportItem->Value = HID_ReadReportBits(ReportData, ReportItem);
 
-	while (DataBitsRem--)
+	return true;
+}
+
+uint8_t USB_GetHIDReportItems(const uint8_t* ReportData,
+                              HID_ReportInfo_t* const ParserData,
+                              const uint8_t ReportID,
+                              const uint8_t ReportType)
+{
+	uint8_t ItemsDecoded = 0;
+
+	if (ReportID && (ReportData[0] != ReportID))
+	  return 0;
+
+	uint8_t i;
+	for (i = 0; i < ParserData->TotalReportItems; i++)
+	{
+		HID_ReportItem_t* ReportItem = &ParserData->ReportItems[i];
+
+		if ((ReportItem->ReportID != ReportID) || (ReportItem->ItemType != ReportType))
+		  continue;
+
+		ReportItem->PreviousValue = ReportItem->Value;
+		ReportItem->Value = HID_ReadReportBits(ReportData, ReportItem);
+		ItemsDecoded++;
+	}
+
+	return ItemsDecoded;
+}
+
+/* Compares words FirstWord to LastWord of two reports of ReportSize bytes, the last word may be partial */
+static bool HID_ReportWordsDiffer(const uint8_t* ReportData,
+                                  const uint8_t* PreviousReportData,
+                                  const uint16_t ReportSize,
+                                  const uint16_t FirstWord,
+                                  const uint16_t LastWord)
+{
+	uint16_t Word;
+	for (Word = FirstWord; Word <= LastWord; Word++)
 	{
-		if (ReportData[CurrentBit / 8] & (1 << (CurrentBit % 8)))
-		  ReportItem->Value |= BitMask;
+		uint16_t Offset = (Word << 2);
+		uint32_t NewWord  = 0;
+		uint32_t PrevWord = 0;
+
+		/* The buffers need not be word aligned, so go through memcpy, which becomes a single load where possible */
+		memcpy(&NewWord,  &ReportData[Offset],         MIN(4, ReportSize - Offset));
+		memcpy(&PrevWord, &PreviousReportData[Offset], MIN(4, ReportSize - Offset));
 
-		CurrentBit++;
-		BitMask <<= 1;
+		if (NewWord ^ PrevWord)
+		  return true;
 	}
 
-	return true;
+	return false;
+}
+
+uint8_t USB_GetChangedHIDReportItems(const uint8_t* ReportData,
+                                     uint8_t* const PreviousReportData,
+                                     const uint16_t ReportSize,
+                                     HID_ReportInfo_t* const ParserData,
+                                     const uint8_t ReportID,
+                                     const uint8_t ReportType,
+                                     HID_ReportItemChanged_t ItemChanged)
+{
+	uint16_t TotalWords = ((ReportSize + 3) >> 2);
+	uint8_t  ItemsChanged = 0;
+
+	if (!(ReportSize))
+	  return 0;
+
+	if (ReportID && (ReportData[0] != ReportID))
+	  return 0;
+
+	if (!(HID_ReportWordsDiffer(ReportData, PreviousReportData, ReportSize, 0, TotalWords - 1)))
+	  return 0;
+
+	uint8_t i;
+	for (i = 0; i < ParserData->TotalReportItems; i++)
+	{
+		HID_ReportItem_t* ReportItem = &ParserData->ReportItems[i];
+
+		if ((ReportItem->ReportID != ReportID) || (ReportItem->ItemType != ReportType))
+		  continue;
+
+		uint16_t FirstWord = (ReportItem->ByteOffset >> 2);
+		uint16_t LastWord  = ((ReportItem->ByteOffset + ReportItem->ByteCount - 1) >> 2);
+
+		if (LastWord >= TotalWords)
+		  continue;
+
+		/* An item spans at most two words, so comparing them again is cheaper than keeping a changed word map */
+		if (!(HID_ReportWordsDiffer(ReportData, PreviousReportData, ReportSize, FirstWord, LastWord)))
+		  continue;
+
+		uint32_t NewValue = HID_ReadReportBits(ReportData, ReportItem);
+
+		/* A changed word may still leave this item's own bits untouched */
+		if (NewValue == ReportItem->Value)
+		  continue;
+
+		ReportItem->PreviousValue = ReportItem->Value;
+		ReportItem->Value         = NewValue;
+		ItemsChanged++;
+
+		if (ItemChanged != NULL)
+		  ItemChanged(ReportItem);
+	}
+
+	memcpy(PreviousReportData, ReportData, ReportSize);
+
+	return ItemsChanged;
+}
+
+uint8_t USB_GetHIDReportItemColumns(const uint8_t* Reports,
+                                    const uint16_t ReportStride,
+                                    const uint32_t TotalReports,
+                                    HID_ReportInfo_t* const ParserData,
+                                    const uint8_t ReportID,
+                                    const uint8_t ReportType,
+                                    uint32_t* Columns)
+{
+	uint8_t TotalColumns = 0;
+
+	uint8_t i;
+	for (i = 0; i < ParserData->TotalReportItems; i++)
+	{
+		const HID_ReportItem_t* ReportItem = &ParserData->ReportItems[i];
+
+		if ((ReportItem->ReportID != ReportID) || (ReportItem->ItemType != ReportType))
+		  continue;
+
+		const uint8_t* Report = Reports;
+
+		uint32_t Row;
+		for (Row = 0; Row < TotalReports; Row++)
+		{
+			if (ReportID && (Report[0] != ReportID))
+			  Columns[Row] = 0;
+			else
+			  Columns[Row] = HID_ReadReportBits(Report, ReportItem);
+
+			Report += ReportStride;
+		}
+
+		Columns += TotalReports;
+		TotalColumns++;
+	}
+
+	return TotalColumns;
+}
+
+HID_ReportItem_t* USB_FindHIDReportItem(HID_ReportInfo_t* const ParserData,
+                                        const uint16_t UsagePage,
+                                        const uint16_t Usage,
+                                        const uint8_t ReportID,
+                                        const uint8_t ItemType)
+{
+	uint32_t Key    = HID_ItemIndexKey(UsagePage, Usage);
+	uint16_t SubKey = HID_ItemIndexSubKey(ReportID, ItemType);
+	uint8_t  Low    = 0;
+	uint8_t  High   = ParserData->TotalReportItems;
+
+	/* Lower bound binary search, so the first of several matching items is found */
+	while (Low < High)
+	{
+		uint8_t Mid = (Low + High) >> 1;
+
+		if (HID_CompareIndexedItem(&ParserData->ReportItems[ParserData->ItemIndex[Mid]], Key, SubKey) < 0)
+		  Low = Mid + 1;
+		else
+		  High = Mid;
+	}
+
+	if ((Low < ParserData->TotalReportItems) &&
+	    !(HID_CompareIndexedItem(&ParserData->ReportItems[ParserData->ItemIndex[Low]], Key, SubKey)))
+	{
+		return &ParserData->ReportItems[ParserData->ItemIndex[Low]];
+	}
+
+	return NULL;
 }
 
 void USB_SetHIDReportItemInfo(uint8_t* ReportData,
@@ -328,40 +978,30 @@ void USB_SetHIDReportItemInfo(uint8_t* ReportData,
 	if (ReportItem == NULL)
 	  return;
 
-	uint16_t DataBitsRem  = ReportItem->Attributes.BitSize;
-	uint16_t CurrentBit   = ReportItem->BitOffset;
-	uint32_t BitMask      = (1 << 0);
-
 	if (ReportItem->ReportID)
-	{
-		ReportData[0] = ReportItem->ReportID;
-		ReportData++;
-	}
+	  ReportData[0] = ReportItem->ReportID;
 
 	ReportItem->PreviousValue = ReportItem->Value;
 
-	while (DataBitsRem--)
-	{
-		if (ReportItem->Value & (1 << (CurrentBit % 8)))
-		  ReportData[CurrentBit / 8] |= BitMask;
+	HID_WriteReportBits(ReportData, ReportItem);
+}
 
-		CurrentBit++;
-		BitMask <<= 1;
-	}
+bool USB_IsKnownHIDReportID(HID_ReportInfo_t* const ParserData,
+                            const uint8_t ReportID)
+{
+	return (HID_LookupReportID(ParserData, ReportID) != 0);
 }
 
 uint16_t USB_GetHIDReportSize(HID_ReportInfo_t* const ParserData,
                               const uint8_t ReportID,
                               const uint8_t ReportType)
 {
-	uint8_t i;
-	for (i = 0; i < HID_MAX_REPORT_IDS; i++)
-	{
-		uint16_t ReportSizeBits = ParserData->ReportIDSizes[i].ReportSizeBits[ReportType];
+	uint8_t ReportIndex = HID_LookupReportID(ParserData, ReportID);
 
-		if (ParserData->ReportIDSizes[i].ReportID == ReportID)
-		  return (ReportSizeBits / 8) + ((ReportSizeBits % 8) ? 1 : 0);
-	}
+	if (!(ReportIndex))
+	  return 0;
 
-	return 0;
+	uint16_t ReportSizeBits = ParserData->ReportIDSizes[ReportIndex - 1].ReportSizeBits[ReportType];
+
+	return (ReportSizeBits / 8) + ((ReportSizeBits % 8) ? 1 : 0);
 }
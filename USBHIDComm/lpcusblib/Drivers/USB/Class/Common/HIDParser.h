@@ -63,6 +63,12 @@
  *  This module also contains routines for the processing of data in an actual HID report, using the parsed report
  *  descriptor data as a guide for the encoding.
  *
+ *  By default the parser output is sized at compile time by the \ref HID_MAX_REPORTITEMS, \ref HID_MAX_COLLECTIONS,
+ *  \ref HID_MAX_REPORT_IDS, \ref HID_STATETABLE_STACK_DEPTH and \ref HID_USAGE_STACK_DEPTH limits. When the
+ *  \c HID_PARSER_ARENA compile time token is defined, \ref HID_ReportInfo_t instead references caller supplied
+ *  memory: \ref USB_GetHIDReportArenaSize() measures a report descriptor in a quick pre-pass, and
+ *  \ref USB_ProcessHIDReportArena() parses it into an arena of that size, so memory scales with the actual device.
+ *
  *  @{
  */
 
@@ -158,6 +164,8 @@
 				HID_PARSE_UsageListOverflow           = 6, /**< More than \ref HID_USAGE_STACK_DEPTH usages listed in a row. */
 				HID_PARSE_InsufficientReportIDItems   = 7, /**< More than \ref HID_MAX_REPORT_IDS report IDs in the device. */
 				HID_PARSE_NoUnfilteredReportItems     = 8, /**< All report items from the device were filtered by the filtering callback routine. */
+				HID_PARSE_InsufficientArena           = 9, /**< The arena given to \ref USB_ProcessHIDReportArena() is too small. */
+				HID_PARSE_TruncatedItem               = 10, /**< The report descriptor ended part way through an item. */
 			};
 
 		/* Type Defines: */
@@ -224,6 +232,12 @@
 			typedef struct
 			{
 				uint16_t                    BitOffset;      /**< Bit offset in the IN, OUT or FEATURE report of the item. */
+				uint16_t                    ByteOffset;     /**< Offset of the first report byte holding the item, including any
+				                                             *   report ID prefix byte, see \ref USB_PrepareHIDReportItem().
+				                                             */
+				uint8_t                     BitShift;       /**< Position of the item's least significant bit in its first byte. */
+				uint8_t                     ByteCount;      /**< Number of report bytes the item spans. */
+				uint32_t                    BitMask;        /**< Mask of the item's value bits once shifted down to bit 0. */
 				uint8_t                     ItemType;       /**< Report item type, a value in \ref HID_ReportItemTypes_t. */
 				uint16_t                    ItemFlags;      /**< Item data flags, a mask of HID_IOF_* constants. */
 				uint8_t                     ReportID;       /**< Report ID this item belongs to, or 0x00 if device has only one report */
@@ -256,20 +270,125 @@
 			typedef struct
 			{
 				uint8_t              TotalReportItems; /**< Total number of report items stored in the \c ReportItems array. */
+				#if !defined(HID_PARSER_ARENA)
 				HID_ReportItem_t     ReportItems[HID_MAX_REPORTITEMS]; /**< Report items array, including all IN, OUT
 			                                                            *   and FEATURE items.
 				                                                        */
 				HID_CollectionPath_t CollectionPaths[HID_MAX_COLLECTIONS]; /**< All collection items, referenced
 				                                                            *   by the report items.
 				                                                            */
+				#else
+				HID_ReportItem_t*     ReportItems; /**< Report items array in the parser arena, including all IN, OUT
+				                                    *   and FEATURE items.
+				                                    */
+				HID_CollectionPath_t* CollectionPaths; /**< All collection items in the parser arena, referenced
+				                                        *   by the report items.
+				                                        */
+				#endif
+				#if !defined(HID_PARSER_ARENA)
+				uint8_t              ItemIndex[HID_MAX_REPORTITEMS]; /**< Indexes into \c ReportItems sorted by usage page, usage,
+				                                                      *   report ID and item type, see \ref USB_FindHIDReportItem().
+				                                                      */
+				#else
+				uint8_t*             ItemIndex; /**< Indexes into \c ReportItems sorted by usage page, usage, report ID and item
+				                                 *   type, in the parser arena.
+				                                 */
+				#endif
 				uint8_t              TotalDeviceReports; /**< Number of reports within the HID interface */
+				#if !defined(HID_PARSER_ARENA)
 				HID_ReportSizeInfo_t ReportIDSizes[HID_MAX_REPORT_IDS]; /**< Report sizes for each report in the interface */
+				#else
+				HID_ReportSizeInfo_t* ReportIDSizes; /**< Report sizes for each report in the interface, in the parser arena */
+				#endif
+				#if !defined(HID_PARSER_ARENA)
+				uint8_t              ReportIDLookup[256]; /**< Index plus one into \c ReportIDSizes for each report ID, or zero
+				                                           *   for report IDs the device does not use.
+				                                           */
+				#else
+				uint8_t*             ReportIDLookup; /**< Index plus one into \c ReportIDSizes for each report ID up to the
+				                                      *   highest one used, or zero for report IDs the device does not use.
+				                                      */
+				#endif
 				uint16_t             LargestReportSizeBits; /**< Largest report that the attached device will generate, in bits */
 				bool                 UsingReportIDs; /**< Indicates if the device has at least one REPORT ID
 				                                      *   element in its HID report descriptor.
 				                                      */
+				#if defined(HID_PARSER_ARENA) || defined(__DOXYGEN__)
+				uint8_t              MaxReportItems; /**< Capacity of the \c ReportItems array. */
+				uint8_t              MaxCollections; /**< Capacity of the \c CollectionPaths array. */
+				uint8_t              MaxReportIDs;   /**< Capacity of the \c ReportIDSizes array. */
+				uint16_t             ReportIDLookupSize; /**< Number of entries in the \c ReportIDLookup array. */
+				#endif
 			} HID_ReportInfo_t;
 
+			/** Type define for a routine called by \ref USB_GetChangedHIDReportItems() for each report item whose value
+			 *  changed, after its \c Value and \c PreviousValue members have been updated.
+			 */
+			typedef void (*HID_ReportItemChanged_t)(HID_ReportItem_t* const ReportItem);
+
+			/** \brief HID Parser State Table Structure.
+			 *
+			 *  Type define for the global item state the parser tracks between main items, one per PUSH level.
+			 */
+			typedef struct
+			{
+				 HID_ReportItem_Attributes_t Attributes; /**< Attributes given to the next main item. */
+				 uint8_t                     ReportCount; /**< Current REPORT COUNT value. */
+				 uint8_t                     ReportID; /**< Current REPORT ID value. */
+			} HID_StateTable_t;
+
+			/** \brief HID Parser Context Structure.
+			 *
+			 *  Type define for the state of a report descriptor parse in progress. Its contents are private to the parser.
+			 */
+			typedef struct
+			{
+				HID_ReportInfo_t*     ParserData;
+				HID_StateTable_t*     StateTable;
+				HID_StateTable_t*     CurrStateTable;
+				HID_CollectionPath_t* CurrCollectionPath;
+				HID_ReportSizeInfo_t* CurrReportIDInfo;
+				uint16_t*             UsageList;
+				HID_MinMax_t          UsageMinMax;
+				uint8_t               StateTableDepth;
+				uint8_t               UsageListDepth;
+				uint8_t               UsageListSize;
+			} HID_ParserContext_t;
+
+			#if !defined(HID_PARSER_ARENA) || defined(__DOXYGEN__)
+			/** \brief HID Report Stream Parser Structure.
+			 *
+			 *  Type define for a resumable report descriptor parser, fed with \ref USB_ProcessHIDReportChunk(). It holds
+			 *  everything that has to survive between chunks, including an item split across two chunks, so the
+			 *  descriptor never has to be stored in one buffer.
+			 *
+			 *  \note This is not available when the \c HID_PARSER_ARENA compile time token is defined.
+			 */
+			typedef struct
+			{
+				HID_ParserContext_t Context; /**< Parser state between items. */
+				HID_StateTable_t    StateTable[HID_STATETABLE_STACK_DEPTH]; /**< State table stack for PUSH and POP items. */
+				uint16_t            UsageList[HID_USAGE_STACK_DEPTH]; /**< USAGE items seen since the last main item. */
+				uint8_t             ItemBuffer[5]; /**< Bytes of an item split across chunks. */
+				uint8_t             ItemBufferSize; /**< Number of bytes held in \c ItemBuffer. */
+				uint8_t             ErrorCode; /**< First error met, a value from the \ref HID_Parse_ErrorCodes_t enum. */
+			} HID_ReportParser_t;
+			#endif
+
+			/** \brief HID Parser Arena Limits Structure.
+			 *
+			 *  Type define for the table sizes a report descriptor needs, as measured by \ref USB_GetHIDReportArenaSize().
+			 */
+			typedef struct
+			{
+				uint8_t ReportItems; /**< Number of report items the parser has to store. */
+				uint8_t Collections; /**< Number of COLLECTION items in the descriptor. */
+				uint8_t ReportIDs;   /**< Number of unique report IDs in the descriptor. */
+				uint8_t StackDepth;  /**< Number of state tables needed for the deepest PUSH nesting. */
+				uint8_t UsageDepth;  /**< Longest run of USAGE items before a main item. */
+				uint8_t HighestReportID; /**< Highest report ID used in the descriptor. */
+			} HID_ArenaLimits_t;
+
 		/* Function Prototypes: */
 			/** Function to process a given HID report returned from an attached device, and store it into a given
 			 *  \ref HID_ReportInfo_t structure.
@@ -280,9 +399,112 @@
 			 *
 			 *  \return A value in the \ref HID_Parse_ErrorCodes_t enum.
 			 */
+			#if !defined(HID_PARSER_ARENA) || defined(__DOXYGEN__)
 			uint8_t USB_ProcessHIDReport(const uint8_t* ReportData,
 			                             uint16_t ReportSize,
 			                             HID_ReportInfo_t* const ParserData) ATTR_NON_NULL_PTR_ARG(1) ATTR_NON_NULL_PTR_ARG(3);
+			#endif
+
+			#if !defined(HID_PARSER_ARENA) || defined(__DOXYGEN__)
+			/** Prepares a \ref HID_ReportParser_t instance to parse a HID report descriptor in chunks, as an alternative
+			 *  to \ref USB_ProcessHIDReport() when the descriptor is not available in a single buffer.
+			 *
+			 *  \note This function is not available when the \c HID_PARSER_ARENA compile time token is defined.
+			 *
+			 *  \param[out] Parser      Pointer to the \ref HID_ReportParser_t instance to initialize.
+			 *  \param[out] ParserData  Pointer to a \ref HID_ReportInfo_t instance for the parser output.
+			 */
+			void USB_InitHIDReportParser(HID_ReportParser_t* const Parser,
+			                             HID_ReportInfo_t* const ParserData) ATTR_NON_NULL_PTR_ARG(1) ATTR_NON_NULL_PTR_ARG(2);
+
+			/** Feeds the next chunk of a HID report descriptor to a parser set up with \ref USB_InitHIDReportParser().
+			 *  Chunks may be of any size and may split items; the chunk buffer can be reused once this returns.
+			 *
+			 *  \note This function is not available when the \c HID_PARSER_ARENA compile time token is defined.
+			 *
+			 *  \param[in,out] Parser     Pointer to the \ref HID_ReportParser_t instance.
+			 *  \param[in]     ChunkData  Buffer containing the next part of the HID report table.
+			 *  \param[in]     ChunkSize  Size in bytes of the chunk.
+			 *
+			 *  \return A value in the \ref HID_Parse_ErrorCodes_t enum. Once an error is returned, it is returned again
+			 *          for all later chunks.
+			 */
+			uint8_t USB_ProcessHIDReportChunk(HID_ReportParser_t* const Parser,
+			                                  const uint8_t* ChunkData,
+			                                  uint16_t ChunkSize) ATTR_NON_NULL_PTR_ARG(1);
+
+			/** Completes a chunked parse once the whole HID report descriptor has been fed to the parser.
+			 *
+			 *  \note This function is not available when the \c HID_PARSER_ARENA compile time token is defined.
+			 *
+			 *  \param[in,out] Parser  Pointer to the \ref HID_ReportParser_t instance.
+			 *
+			 *  \return A value in the \ref HID_Parse_ErrorCodes_t enum, the same as \ref USB_ProcessHIDReport() would
+			 *          have returned for the whole descriptor.
+			 */
+			uint8_t USB_FinishHIDReportParser(HID_ReportParser_t* const Parser) ATTR_NON_NULL_PTR_ARG(1);
+			#endif
+
+			/** Computes a 32-bit FNV-1a hash over a HID report descriptor, so that a previously parsed descriptor can be
+			 *  recognised without parsing it again.
+			 *
+			 *  \param[in] ReportData  Buffer containing the device's HID report table.
+			 *  \param[in] ReportSize  Size in bytes of the HID report table.
+			 *
+			 *  \return Hash of the report descriptor.
+			 */
+			uint32_t USB_GetHIDReportDescriptorHash(const uint8_t* ReportData,
+			                                        uint16_t ReportSize) ATTR_NON_NULL_PTR_ARG(1);
+
+			#if !defined(HID_PARSER_ARENA) || defined(__DOXYGEN__)
+			/** Copies the output of \ref USB_ProcessHIDReport() to another \ref HID_ReportInfo_t instance, updating the
+			 *  collection path references of the copy so that it does not depend on the source instance.
+			 *
+			 *  \note This function is not available when the \c HID_PARSER_ARENA compile time token is defined.
+			 *
+			 *  \param[out] Dest    Pointer to the \ref HID_ReportInfo_t instance to copy the parser output to.
+			 *  \param[in]  Source  Pointer to the \ref HID_ReportInfo_t instance holding the parser output.
+			 */
+			void USB_CopyHIDReportInfo(HID_ReportInfo_t* const Dest,
+			                           const HID_ReportInfo_t* const Source) ATTR_NON_NULL_PTR_ARG(1) ATTR_NON_NULL_PTR_ARG(2);
+			#endif
+
+			#if defined(HID_PARSER_ARENA) || defined(__DOXYGEN__)
+			/** Measures the tables a HID report descriptor will need once parsed, without storing any of its items.
+			 *
+			 *  \note This function is only available when the \c HID_PARSER_ARENA compile time token is defined.
+			 *
+			 *  \param[in]  ReportData  Buffer containing the device's HID report table.
+			 *  \param[in]  ReportSize  Size in bytes of the HID report table.
+			 *  \param[out] Limits      Pointer to a \ref HID_ArenaLimits_t instance for the table sizes.
+			 *
+			 *  \return Size in bytes of the arena \ref USB_ProcessHIDReportArena() needs for this report table.
+			 */
+			uint16_t USB_GetHIDReportArenaSize(const uint8_t* ReportData,
+			                                   uint16_t ReportSize,
+			                                   HID_ArenaLimits_t* const Limits) ATTR_NON_NULL_PTR_ARG(1) ATTR_NON_NULL_PTR_ARG(3);
+
+			/** Function to process a given HID report returned from an attached device, and store it into a given
+			 *  \ref HID_ReportInfo_t structure whose item, collection and report ID tables are placed in a caller supplied
+			 *  arena. The arena must stay valid for as long as the parser output is used.
+			 *
+			 *  \note This function is only available when the \c HID_PARSER_ARENA compile time token is defined.
+			 *
+			 *  \param[in]  ReportData  Buffer containing the device's HID report table.
+			 *  \param[in]  ReportSize  Size in bytes of the HID report table.
+			 *  \param[out] ParserData  Pointer to a \ref HID_ReportInfo_t instance for the parser output.
+			 *  \param[in]  Arena       Pointer to a 32-bit aligned buffer for the parser tables.
+			 *  \param[in]  ArenaSize   Size in bytes of the arena, see \ref USB_GetHIDReportArenaSize().
+			 *
+			 *  \return A value in the \ref HID_Parse_ErrorCodes_t enum.
+			 */
+			uint8_t USB_ProcessHIDReportArena(const uint8_t* ReportData,
+			                                  uint16_t ReportSize,
+			                                  HID_ReportInfo_t* const ParserData,
+			                                  void* Arena,
+			                                  const uint16_t ArenaSize) ATTR_NON_NULL_PTR_ARG(1) ATTR_NON_NULL_PTR_ARG(3)
+			                                  ATTR_NON_NULL_PTR_ARG(4);
+			#endif
 
 			/** Extracts the given report item's value out of the given HID report and places it into the Value
 			 *  member of the report item's \ref HID_ReportItem_t structure.
@@ -300,6 +522,94 @@
 			bool USB_GetHIDReportItemInfo(const uint8_t* ReportData,
 			                              HID_ReportItem_t* const ReportItem) ATTR_NON_NULL_PTR_ARG(1);
 
+			/** Extracts the values of all report items of the given report ID and type out of the given HID report,
+			 *  as \ref USB_GetHIDReportItemInfo() would do for each of them in turn.
+			 *
+			 *  \param[in]     ReportData  Buffer containing an IN or FEATURE report from an attached device.
+			 *  \param[in,out] ParserData  Pointer to a \ref HID_ReportInfo_t instance containing the parser output.
+			 *  \param[in]     ReportID    Report ID of the given report, or 0x00 if the device does not use report IDs.
+			 *  \param[in]     ReportType  Type of the given report, a value from the \ref HID_ReportItemTypes_t enum.
+			 *
+			 *  \return Number of report items whose value was extracted.
+			 */
+			uint8_t USB_GetHIDReportItems(const uint8_t* ReportData,
+			                              HID_ReportInfo_t* const ParserData,
+			                              const uint8_t ReportID,
+			                              const uint8_t ReportType) ATTR_NON_NULL_PTR_ARG(1) ATTR_NON_NULL_PTR_ARG(2);
+
+			/** Extracts only the report items of the given report ID and type that changed since the previous report. The new
+			 *  report is compared against a copy of the previous one a 32-bit word at a time, and only the items whose own
+			 *  words changed are extracted; items whose value actually changed are passed to the given routine. The new report
+			 *  is then copied over the previous one, ready for the next call.
+			 *
+			 *  Before the first call, \c PreviousReportData should hold an all zero report matching the values stored in the
+			 *  report items, or a previous report decoded with \ref USB_GetHIDReportItems().
+			 *
+			 *  \param[in]     ReportData          Buffer containing an IN or FEATURE report from an attached device.
+			 *  \param[in,out] PreviousReportData  Buffer containing the previous report of the same ID, updated on return.
+			 *  \param[in]     ReportSize          Size in bytes of the report, including any report ID prefix.
+			 *  \param[in,out] ParserData          Pointer to a \ref HID_ReportInfo_t instance containing the parser output.
+			 *  \param[in]     ReportID            Report ID of the given report, or 0x00 if the device does not use report IDs.
+			 *  \param[in]     ReportType          Type of the given report, a value from the \ref HID_ReportItemTypes_t enum.
+			 *  \param[in]     ItemChanged         Routine to call for each changed report item, or \c NULL if not required.
+			 *
+			 *  \return Number of report items whose value changed.
+			 */
+			uint8_t USB_GetChangedHIDReportItems(const uint8_t* ReportData,
+			                                     uint8_t* const PreviousReportData,
+			                                     const uint16_t ReportSize,
+			                                     HID_ReportInfo_t* const ParserData,
+			                                     const uint8_t ReportID,
+			                                     const uint8_t ReportType,
+			                                     HID_ReportItemChanged_t ItemChanged) ATTR_NON_NULL_PTR_ARG(1)
+			                                     ATTR_NON_NULL_PTR_ARG(2) ATTR_NON_NULL_PTR_ARG(4);
+
+			/** Extracts the report items of the given report ID and type out of an array of recorded reports into columns,
+			 *  one column per item. Each item's byte offset, shift and mask are fixed for all reports, so each column is
+			 *  filled by a tight loop the compiler can unroll or vectorize. The report items themselves are not modified.
+			 *
+			 *  \note Reports whose first byte does not match a non-zero \c ReportID still get a row, holding zero.
+			 *
+			 *  \param[in]  Reports       Array of reports, each including any report ID prefix.
+			 *  \param[in]  ReportStride  Distance in bytes between the start of consecutive reports in \c Reports.
+			 *  \param[in]  TotalReports  Number of reports in \c Reports.
+			 *  \param[in]  ParserData    Pointer to a \ref HID_ReportInfo_t instance containing the parser output.
+			 *  \param[in]  ReportID      Report ID of the reports, or 0x00 if the device does not use report IDs.
+			 *  \param[in]  ReportType    Type of the reports, a value from the \ref HID_ReportItemTypes_t enum.
+			 *  \param[out] Columns       Output array of \c TotalReports values per matching item, in the order the items
+			 *                            appear in the report descriptor.
+			 *
+			 *  \return Number of columns written, one per matching report item.
+			 */
+			uint8_t USB_GetHIDReportItemColumns(const uint8_t* Reports,
+			                                    const uint16_t ReportStride,
+			                                    const uint32_t TotalReports,
+			                                    HID_ReportInfo_t* const ParserData,
+			                                    const uint8_t ReportID,
+			                                    const uint8_t ReportType,
+			                                    uint32_t* Columns) ATTR_NON_NULL_PTR_ARG(1) ATTR_NON_NULL_PTR_ARG(4)
+			                                    ATTR_NON_NULL_PTR_ARG(7);
+
+			/** Looks up a report item by its usage and report, using the sorted item index built by the parser. The
+			 *  returned item already holds the precomputed extraction layout, so it may be cached by the application
+			 *  and passed straight to \ref USB_GetHIDReportItemInfo() for every received report.
+			 *
+			 *  If several items share the same usage, report ID and type, the first one in descriptor order is returned.
+			 *
+			 *  \param[in] ParserData  Pointer to a \ref HID_ReportInfo_t instance containing the parser output.
+			 *  \param[in] UsagePage   Usage page of the item to find.
+			 *  \param[in] Usage       Usage of the item to find.
+			 *  \param[in] ReportID    Report ID of the item to find, or 0x00 if the device does not use report IDs.
+			 *  \param[in] ItemType    Type of the item to find, a value from the \ref HID_ReportItemTypes_t enum.
+			 *
+			 *  \return Pointer to the report item, or \c NULL if no stored item matches.
+			 */
+			HID_ReportItem_t* USB_FindHIDReportItem(HID_ReportInfo_t* const ParserData,
+			                                        const uint16_t UsagePage,
+			                                        const uint16_t Usage,
+			                                        const uint8_t ReportID,
+			                                        const uint8_t ItemType) ATTR_NON_NULL_PTR_ARG(1);
+
 			/** Retrieves the given report item's value out of the \c Value member of the report item's
 			 *  \ref HID_ReportItem_t structure and places it into the correct position in the HID report
 			 *  buffer. The report buffer is assumed to have the appropriate bits cleared before calling
@@ -316,7 +626,27 @@
 			void USB_SetHIDReportItemInfo(uint8_t* ReportData,
 			                              HID_ReportItem_t* const ReportItem) ATTR_NON_NULL_PTR_ARG(1);
 
-			/** Retrieves the size of a given HID report in bytes from its Report ID.
+			/** Precomputes the byte offset, shift and mask of a report item from its \c BitOffset, \c BitSize and
+			 *  \c ReportID, so that \ref USB_GetHIDReportItemInfo() and \ref USB_SetHIDReportItemInfo() can move the
+			 *  item's value with a few byte loads and a shift instead of one bit at a time. This is done for every item
+			 *  by \ref USB_ProcessHIDReport(), and only needs to be called for items altered or built by the application.
+			 *
+			 *  \param[in,out] ReportItem  Pointer to the report item whose layout is to be computed.
+			 */
+			void USB_PrepareHIDReportItem(HID_ReportItem_t* const ReportItem) ATTR_NON_NULL_PTR_ARG(1);
+
+			/** Determines if the attached device uses a given report ID, with a single table lookup. This allows reports
+			 *  with a malformed or unexpected report ID to be rejected before any of their data is processed.
+			 *
+			 *  \param[in] ParserData  Pointer to a \ref HID_ReportInfo_t instance containing the parser output.
+			 *  \param[in] ReportID    Report ID to check, or 0x00 if the device does not use report IDs.
+			 *
+			 *  \return Boolean \c true if the report ID appears in the device's report descriptor, \c false otherwise.
+			 */
+			bool USB_IsKnownHIDReportID(HID_ReportInfo_t* const ParserData,
+			                            const uint8_t ReportID) ATTR_NON_NULL_PTR_ARG(1);
+
+			/** Retrieves the size of a given HID report in bytes from its Report ID, in constant time.
 			 *
 			 *  \param[in] ParserData  Pointer to a \ref HID_ReportInfo_t instance containing the parser output.
 			 *  \param[in] ReportID    Report ID of the report whose size is to be determined.
@@ -345,16 +675,74 @@
 			 */
 			bool CALLBACK_HIDParser_FilterHIDReportItem(HID_ReportItem_t* const CurrentItem);
 
-	/* Private Interface - For use in library only: */
-	#if !defined(__DOXYGEN__)
-		/* Type Defines: */
-			typedef struct
+		/* Inline Functions: */
+			/** Retrieves a field from a report whose layout is fixed at compile time, such as a device's own report or the
+			 *  report of a known peripheral. When the bit offset and size are constants, the compiler reduces the call to a
+			 *  fixed set of byte loads, shifts and a mask, with no report descriptor parsed at run time.
+			 *
+			 *  \param[in] ReportData  Buffer containing the report, including any report ID prefix.
+			 *  \param[in] BitOffset   Offset in bits of the field from the start of \c ReportData.
+			 *  \param[in] BitSize     Size in bits of the field, from 1 to 32.
+			 *
+			 *  \return Value of the field.
+			 */
+			static inline uint32_t USB_GetHIDReportField(const uint8_t* ReportData,
+			                                             const uint16_t BitOffset,
+			                                             const uint8_t BitSize) ATTR_ALWAYS_INLINE ATTR_NON_NULL_PTR_ARG(1);
+			static inline uint32_t USB_GetHIDReportField(const uint8_t* ReportData,
+			                                             const uint16_t BitOffset,
+			                                             const uint8_t BitSize)
 			{
-				 HID_ReportItem_Attributes_t Attributes;
-				 uint8_t                     ReportCount;
-				 uint8_t                     ReportID;
-			} HID_StateTable_t;
-	#endif
+				const uint8_t* Data      = &ReportData[BitOffset >> 3];
+				uint8_t        BitShift  = (BitOffset & 0x07);
+				uint8_t        ByteCount = ((BitShift + BitSize + 7) >> 3);
+				uint32_t       Bits      = 0;
+
+				uint8_t i;
+				for (i = 0; (i < ByteCount) && (i < 4); i++)
+				  Bits |= ((uint32_t)Data[i] << (i << 3));
+
+				Bits >>= BitShift;
+
+				if (ByteCount > 4)
+				  Bits |= ((uint32_t)Data[4] << (32 - BitShift));
+
+				return (BitSize >= 32) ? Bits : (Bits & ((1UL << BitSize) - 1));
+			}
+
+			/** Stores a field into a report whose layout is fixed at compile time, the counterpart of
+			 *  \ref USB_GetHIDReportField(). Bits of the report outside the field are left unchanged.
+			 *
+			 *  \param[out] ReportData  Buffer containing the report, including any report ID prefix.
+			 *  \param[in]  BitOffset   Offset in bits of the field from the start of \c ReportData.
+			 *  \param[in]  BitSize     Size in bits of the field, from 1 to 32.
+			 *  \param[in]  Value       Value to store, truncated to \c BitSize bits.
+			 */
+			static inline void USB_SetHIDReportField(uint8_t* ReportData,
+			                                         const uint16_t BitOffset,
+			                                         const uint8_t BitSize,
+			                                         const uint32_t Value) ATTR_ALWAYS_INLINE ATTR_NON_NULL_PTR_ARG(1);
+			static inline void USB_SetHIDReportField(uint8_t* ReportData,
+			                                         const uint16_t BitOffset,
+			                                         const uint8_t BitSize,
+			                                         const uint32_t Value)
+			{
+				uint8_t* Data      = &ReportData[BitOffset >> 3];
+				uint8_t  BitShift  = (BitOffset & 0x07);
+				uint8_t  ByteCount = ((BitShift + BitSize + 7) >> 3);
+				uint32_t Mask      = (BitSize >= 32) ? 0xFFFFFFFF : ((1UL << BitSize) - 1);
+
+				uint8_t i;
+				for (i = 0; i < ByteCount; i++)
+				{
+					/* Bits of the mask and value that land in this byte of the report */
+					int8_t  Shift     = (int8_t)((i << 3) - BitShift);
+					uint8_t ByteMask  = (Shift < 0) ? (uint8_t)(Mask << -Shift)  : (uint8_t)(Mask >> Shift);
+					uint8_t ByteValue = (Shift < 0) ? (uint8_t)(Value << -Shift) : (uint8_t)(Value >> Shift);
+
+					Data[i] = ((Data[i] & ~ByteMask) | (ByteValue & ByteMask));
+				}
+			}
 
 	/* Disable C linkage for C++ Compilers: */
 		#if defined(__cplusplus)
@@ -61,7 +61,8 @@ void HID_Device_ProcessControlRequest(USB_ClassInfo_HID_Device_t* const HIDInter
 
 				CALLBACK_HID_Device_CreateHIDReport(HIDInterfaceInfo, &ReportID, ReportType, ReportData, &ReportSize);
 
-				if (HIDInterfaceInfo->Config.PrevReportINBuffer != NULL)
+				/* Only input reports are compared against the previous one, a feature report must not overwrite it */
+				if ((HIDInterfaceInfo->Config.PrevReportINBuffer != NULL) && (ReportType == HID_REPORT_ITEM_In))
 				{
 					memcpy(HIDInterfaceInfo->Config.PrevReportINBuffer, ReportData,
 					       HIDInterfaceInfo->Config.PrevReportINBufferSize);
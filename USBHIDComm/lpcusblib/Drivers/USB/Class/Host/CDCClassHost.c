@@ -150,14 +150,12 @@ uint8_t CDC_Host_ConfigurePipes(USB_ClassInfo_CDC_Host_t* const CDCInterfaceInfo
 			continue;
 		}
 		
-		if (!(Pipe_ConfigurePipe(portnum,PipeNum, Type, Token, EndpointAddress, Size,
-		                         DoubleBanked ? PIPE_BANK_DOUBLE : PIPE_BANK_SINGLE)))
+		/* Interrupt pipes are opened with their interval, so their bandwidth is reserved only in the frames they use */
+		if (!(Pipe_ConfigurePipeInterval(portnum,PipeNum, Type, Token, EndpointAddress, Size,
+		                                 DoubleBanked ? PIPE_BANK_DOUBLE : PIPE_BANK_SINGLE, InterruptPeriod)))
 		{
 			return CDC_ENUMERROR_PipeConfigurationFailed;
 		}
-		
-		if (InterruptPeriod)
-		  Pipe_SetInterruptPeriod(InterruptPeriod);
 	}
 
 	CDCInterfaceInfo->State.ControlInterfaceNumber = CDCControlInterface->InterfaceNumber;
@@ -138,14 +138,12 @@ uint8_t HID_Host_ConfigurePipes(USB_ClassInfo_HID_Host_t* const HIDInterfaceInfo
 			continue;
 		}
 
-		if (!(Pipe_ConfigurePipe(portnum,PipeNum, Type, Token, EndpointAddress, Size,
-		                         DoubleBanked ? PIPE_BANK_DOUBLE : PIPE_BANK_SINGLE)))
+		/* Interrupt pipes are opened with their interval, so their bandwidth is reserved only in the frames they use */
+		if (!(Pipe_ConfigurePipeInterval(portnum,PipeNum, Type, Token, EndpointAddress, Size,
+		                                 DoubleBanked ? PIPE_BANK_DOUBLE : PIPE_BANK_SINGLE, InterruptPeriod)))
 		{
 			return HID_ENUMERROR_PipeConfigurationFailed;
 		}
-		
-		if (InterruptPeriod)
-		  Pipe_SetInterruptPeriod(InterruptPeriod);
 	}
 
 	HIDInterfaceInfo->State.InterfaceNumber      = HIDInterface->InterfaceNumber;
@@ -246,6 +244,15 @@ uint8_t HID_Host_ReceiveReport(USB_ClassInfo_HID_Host_t* const HIDInterfaceInfo,
 		if (HIDInterfaceInfo->Config.HIDParserData->UsingReportIDs)
 		{
 			ReportID = Pipe_Read_8(portnum);
+
+			if (!(USB_IsKnownHIDReportID(HIDInterfaceInfo->Config.HIDParserData, ReportID)))
+			{
+				Pipe_ClearIN(portnum);
+				Pipe_Freeze();
+
+				return HID_ERROR_LOGICAL;
+			}
+
 			*(BufferPos++) = ReportID;
 		}
 
@@ -383,12 +390,74 @@ uint8_t HID_Host_SetIdlePeriod(USB_ClassInfo_HID_Host_t* const HIDInterfaceInfo,
 	return USB_Host_SendControlRequest(portnum,NULL);
 }
 
+#if !defined(HID_PARSER_ARENA) && (HID_HOST_PARSER_CACHE_ENTRIES == 0)
+	#define HID_HOST_STREAM_REPORT_DESCRIPTOR
+#endif
+
+#if !defined(HID_HOST_BOOT_PROTOCOL_ONLY) && (HID_HOST_PARSER_CACHE_ENTRIES > 0)
+static HID_Host_ParserCacheEntry_t HID_Host_ParserCache[HID_HOST_PARSER_CACHE_ENTRIES];
+static uint32_t                    HID_Host_ParserCacheClock;
+
+void HID_Host_FlushParserCache(void)
+{
+	memset(HID_Host_ParserCache, 0x00, sizeof(HID_Host_ParserCache));
+}
+
+static HID_Host_ParserCacheEntry_t* HID_Host_FindParserCacheEntry(const USB_ClassInfo_HID_Host_t* const HIDInterfaceInfo,
+                                                                  const uint32_t ReportHash)
+{
+	uint8_t i;
+	for (i = 0; i < HID_HOST_PARSER_CACHE_ENTRIES; i++)
+	{
+		HID_Host_ParserCacheEntry_t* Entry = &HID_Host_ParserCache[i];
+
+		if (Entry->ReportSize &&
+		    (Entry->ReportSize == HIDInterfaceInfo->State.HIDReportSize) &&
+		    (Entry->ReportHash == ReportHash) &&
+		    (Entry->VendorID   == HIDInterfaceInfo->State.VendorID) &&
+		    (Entry->ProductID  == HIDInterfaceInfo->State.ProductID))
+		{
+			return Entry;
+		}
+	}
+
+	return NULL;
+}
+
+static void HID_Host_StoreParserCacheEntry(const USB_ClassInfo_HID_Host_t* const HIDInterfaceInfo,
+                                           const uint32_t ReportHash)
+{
+	HID_Host_ParserCacheEntry_t* Entry = &HID_Host_ParserCache[0];
+
+	/* Replace an unused entry, or the least recently used one if the cache is full */
+	uint8_t i;
+	for (i = 1; (i < HID_HOST_PARSER_CACHE_ENTRIES) && Entry->ReportSize; i++)
+	{
+		if (!(HID_Host_ParserCache[i].ReportSize) || (HID_Host_ParserCache[i].LastUsed < Entry->LastUsed))
+		  Entry = &HID_Host_ParserCache[i];
+	}
+
+	Entry->VendorID   = HIDInterfaceInfo->State.VendorID;
+	Entry->ProductID  = HIDInterfaceInfo->State.ProductID;
+	Entry->ReportSize = HIDInterfaceInfo->State.HIDReportSize;
+	Entry->ReportHash = ReportHash;
+	Entry->LastUsed   = ++HID_Host_ParserCacheClock;
+
+	USB_CopyHIDReportInfo(&Entry->ParserData, HIDInterfaceInfo->Config.HIDParserData);
+}
+#endif
+
 #if !defined(HID_HOST_BOOT_PROTOCOL_ONLY)
 uint8_t HID_Host_SetReportProtocol(USB_ClassInfo_HID_Host_t* const HIDInterfaceInfo)
 {
 	uint8_t ErrorCode;
 	uint8_t portnum = HIDInterfaceInfo->Config.PortNumber;
+	#if defined(HID_HOST_STREAM_REPORT_DESCRIPTOR)
+	uint8_t            HIDReportChunk[HID_HOST_REPORT_CHUNK_SIZE];
+	HID_ReportParser_t HIDReportParser;
+	#else
 	uint8_t HIDReportData[HIDInterfaceInfo->State.HIDReportSize];
+	#endif
 
 	USB_ControlRequest = (USB_Request_Header_t)
 		{
@@ -401,8 +470,35 @@ uint8_t HID_Host_SetReportProtocol(USB_ClassInfo_HID_Host_t* const HIDInterfaceI
 
 	Pipe_SelectPipe(portnum,PIPE_CONTROLPIPE);
 
+	#if defined(HID_HOST_STREAM_REPORT_DESCRIPTOR)
+	if ((ErrorCode = USB_Host_SendControlRequest(portnum,NULL)) != HOST_SENDCONTROL_Successful)
+	  return ErrorCode;
+
+	/* Parse the descriptor straight out of the control pipe, a chunk at a time, before the pipe is reused */
+	if (HIDInterfaceInfo->Config.HIDParserData != NULL)
+	  USB_InitHIDReportParser(&HIDReportParser, HIDInterfaceInfo->Config.HIDParserData);
+
+	uint16_t BytesRemaining = HIDInterfaceInfo->State.HIDReportSize;
+
+	while (BytesRemaining)
+	{
+		uint16_t ChunkSize = MIN(BytesRemaining, sizeof(HIDReportChunk));
+		uint16_t i;
+
+		for (i = 0; i < ChunkSize; i++)
+		  HIDReportChunk[i] = Pipe_Read_8(portnum);
+
+		if (HIDInterfaceInfo->Config.HIDParserData != NULL)
+		  USB_ProcessHIDReportChunk(&HIDReportParser, HIDReportChunk, ChunkSize);
+
+		BytesRemaining -= ChunkSize;
+	}
+
+	Pipe_ClearIN(portnum);
+	#else
 	if ((ErrorCode = USB_Host_SendControlRequest(portnum,HIDReportData)) != HOST_SENDCONTROL_Successful)
 	  return ErrorCode;
+	#endif
 
 	if (HIDInterfaceInfo->State.UsingBootProtocol)
 	{
@@ -424,11 +520,37 @@ uint8_t HID_Host_SetReportProtocol(USB_ClassInfo_HID_Host_t* const HIDInterfaceI
 	if (HIDInterfaceInfo->Config.HIDParserData == NULL)
 	  return HID_ERROR_LOGICAL;
 
+	#if (HID_HOST_PARSER_CACHE_ENTRIES > 0)
+	uint32_t ReportHash = USB_GetHIDReportDescriptorHash(HIDReportData, HIDInterfaceInfo->State.HIDReportSize);
+	HID_Host_ParserCacheEntry_t* CacheEntry = HID_Host_FindParserCacheEntry(HIDInterfaceInfo, ReportHash);
+
+	if (CacheEntry != NULL)
+	{
+		CacheEntry->LastUsed = ++HID_Host_ParserCacheClock;
+		USB_CopyHIDReportInfo(HIDInterfaceInfo->Config.HIDParserData, &CacheEntry->ParserData);
+	}
+	else
+	#endif
+	#if defined(HID_HOST_STREAM_REPORT_DESCRIPTOR)
+	if ((ErrorCode = USB_FinishHIDReportParser(&HIDReportParser)) != HID_PARSE_Successful)
+	#elif defined(HID_PARSER_ARENA)
+	if ((ErrorCode = USB_ProcessHIDReportArena(HIDReportData, HIDInterfaceInfo->State.HIDReportSize,
+	                                           HIDInterfaceInfo->Config.HIDParserData,
+	                                           HIDInterfaceInfo->Config.HIDParserArena,
+	                                           HIDInterfaceInfo->Config.HIDParserArenaSize)) != HID_PARSE_Successful)
+	#else
 	if ((ErrorCode = USB_ProcessHIDReport(HIDReportData, HIDInterfaceInfo->State.HIDReportSize,
 	                                      HIDInterfaceInfo->Config.HIDParserData)) != HID_PARSE_Successful)
+	#endif
 	{
 		return HID_ERROR_LOGICAL | ErrorCode;
 	}
+	#if (HID_HOST_PARSER_CACHE_ENTRIES > 0)
+	else
+	{
+		HID_Host_StoreParserCacheEntry(HIDInterfaceInfo, ReportHash);
+	}
+	#endif
 
 	uint8_t LargestReportSizeBits = HIDInterfaceInfo->Config.HIDParserData->LargestReportSizeBits;
 	HIDInterfaceInfo->State.LargestReportSize = (LargestReportSizeBits >> 3) + ((LargestReportSizeBits & 0x07) != 0);
@@ -50,6 +50,16 @@
  *  \section Sec_ModDescription Module Description
  *  Host Mode USB Class driver framework interface, for the HID USB Class driver.
  *
+ *  Unless the parser cache or the \c HID_PARSER_ARENA compile time token is used, \ref HID_Host_SetReportProtocol() parses
+ *  the device's report descriptor as it is read out of the control pipe, in chunks of \c HID_HOST_REPORT_CHUNK_SIZE bytes
+ *  (64 by default), so no buffer as large as the descriptor is needed.
+ *
+ *  When the \c HID_HOST_PARSER_CACHE_ENTRIES compile time token is set to a non-zero value, \ref HID_Host_SetReportProtocol()
+ *  keeps the parser output of the most recently seen devices, keyed by vendor ID, product ID and a hash of the report
+ *  descriptor. A device model that is attached again then has its parser output copied from the cache instead of its
+ *  report descriptor being parsed again. Each entry holds a full \ref HID_ReportInfo_t, and the cache is not available
+ *  together with the \c HID_PARSER_ARENA compile time token.
+ *
  *  @{
  */
 
@@ -70,6 +80,18 @@
 			#error Do not include this file directly. Include LPCUSBlib/Drivers/USB.h instead.
 		#endif
 
+		#if !defined(HID_HOST_PARSER_CACHE_ENTRIES)
+			#define HID_HOST_PARSER_CACHE_ENTRIES  0
+		#endif
+
+		#if !defined(HID_HOST_REPORT_CHUNK_SIZE)
+			#define HID_HOST_REPORT_CHUNK_SIZE     64
+		#endif
+
+		#if (HID_HOST_PARSER_CACHE_ENTRIES > 0) && defined(HID_PARSER_ARENA)
+			#error The HID_HOST_PARSER_CACHE_ENTRIES and HID_PARSER_ARENA compile time tokens are mutually exclusive.
+		#endif
+
 	/* Public Interface - May be used in end-application: */
 		/* Macros: */
 			/** Error code for some HID Host functions, indicating a logical (and not hardware) error. */
@@ -103,6 +125,14 @@
 					                                  *  \note When the \c HID_HOST_BOOT_PROTOCOL_ONLY compile time token is defined,
 					                                  *        this method is unavailable.
 					                                  */
+					#if defined(HID_PARSER_ARENA) || defined(__DOXYGEN__)
+					void*    HIDParserArena; /**< Arena holding the tables of \c HIDParserData, must stay valid while the
+					                          *   device is attached.
+					                          *
+					                          *  \note This is only available when the \c HID_PARSER_ARENA compile time token is defined.
+					                          */
+					uint16_t HIDParserArenaSize; /**< Size in bytes of the \c HIDParserArena buffer. */
+					#endif
 					#endif
 
 					uint8_t  PortNumber;		/**< Port number that this interface is running.
@@ -131,6 +161,17 @@
 					uint16_t HIDReportSize; /**< Size in bytes of the HID report descriptor in the device. */
 
 					uint8_t LargestReportSize; /**< Largest report the device will send, in bytes. */
+
+					#if (HID_HOST_PARSER_CACHE_ENTRIES > 0) || defined(__DOXYGEN__)
+					uint16_t VendorID; /**< Vendor ID of the attached device, used as part of the parser cache key. This should be
+					                    *   set by the application from the device descriptor after \ref HID_Host_ConfigurePipes()
+					                    *   and before \ref HID_Host_SetReportProtocol(). It may be left at zero, in which case
+					                    *   the cache is keyed by the report descriptor alone.
+					                    *
+					                    *  \note This is only available when \c HID_HOST_PARSER_CACHE_ENTRIES is non-zero.
+					                    */
+					uint16_t ProductID; /**< Product ID of the attached device, see \c VendorID. */
+					#endif
 				} State; /**< State data for the USB class interface within the device. All elements in this section
 						  *   <b>may</b> be set to initial values, but may also be ignored to default to sane values when
 						  *   the interface is enumerated.
@@ -179,7 +220,8 @@
 			 *  \param[in,out] HIDInterfaceInfo  Pointer to a structure containing a HID Class host configuration and state.
 			 *  \param[in]     Buffer            Buffer to store the received report into.
 			 *
-			 *  \return An error code from the \ref Pipe_Stream_RW_ErrorCodes_t enum.
+			 *  \return An error code from the \ref Pipe_Stream_RW_ErrorCodes_t enum, or \ref HID_ERROR_LOGICAL if the report
+			 *          carried a report ID not found in the device's report descriptor, in which case it is discarded.
 			 */
 			uint8_t HID_Host_ReceiveReport(USB_ClassInfo_HID_Host_t* const HIDInterfaceInfo,
 			                               void* Buffer) ATTR_NON_NULL_PTR_ARG(1) ATTR_NON_NULL_PTR_ARG(2);
@@ -289,6 +331,15 @@
 			uint8_t HID_Host_SetReportProtocol(USB_ClassInfo_HID_Host_t* const HIDInterfaceInfo) ATTR_NON_NULL_PTR_ARG(1);
 			#endif
 
+			#if (!defined(HID_HOST_BOOT_PROTOCOL_ONLY) && (HID_HOST_PARSER_CACHE_ENTRIES > 0)) || defined(__DOXYGEN__)
+			/** Discards all parser output held in the HID host parser cache. This should be called if the application changes
+			 *  the filtering done by \ref CALLBACK_HIDParser_FilterHIDReportItem(), as cached entries were filtered when parsed.
+			 *
+			 *  \note This function is only available when \c HID_HOST_PARSER_CACHE_ENTRIES is non-zero.
+			 */
+			void HID_Host_FlushParserCache(void);
+			#endif
+
 		/* Inline Functions: */
 			/** General management task for a given Human Interface Class host class interface, required for the correct operation of
 			 *  the interface. This should be called frequently in the main program loop, before the master USB management task
@@ -304,6 +355,19 @@
 
 	/* Private Interface - For use in library only: */
 	#if !defined(__DOXYGEN__)
+		/* Type Defines: */
+			#if (HID_HOST_PARSER_CACHE_ENTRIES > 0)
+			typedef struct
+			{
+				uint16_t         VendorID;
+				uint16_t         ProductID;
+				uint16_t         ReportSize;
+				uint32_t         ReportHash;
+				uint32_t         LastUsed;
+				HID_ReportInfo_t ParserData;
+			} HID_Host_ParserCacheEntry_t;
+			#endif
+
 		/* Function Prototypes: */
 			#if defined(__INCLUDE_FROM_HID_HOST_C)
 				static uint8_t DCOMP_HID_Host_NextHIDInterface(void* const CurrentDescriptor)
@@ -152,14 +152,12 @@ uint8_t RNDIS_Host_ConfigurePipes(USB_ClassInfo_RNDIS_Host_t* const RNDISInterfa
 			continue;
 		}
 		
-		if (!(Pipe_ConfigurePipe(portnum,PipeNum, Type, Token, EndpointAddress, Size,
-		                         DoubleBanked ? PIPE_BANK_DOUBLE : PIPE_BANK_SINGLE)))
+		/* Interrupt pipes are opened with their interval, so their bandwidth is reserved only in the frames they use */
+		if (!(Pipe_ConfigurePipeInterval(portnum,PipeNum, Type, Token, EndpointAddress, Size,
+		                                 DoubleBanked ? PIPE_BANK_DOUBLE : PIPE_BANK_SINGLE, InterruptPeriod)))
 		{
 			return CDC_ENUMERROR_PipeConfigurationFailed;
 		}
-		
-		if (InterruptPeriod)
-		  Pipe_SetInterruptPeriod(InterruptPeriod);
 	}
 
 	RNDISInterfaceInfo->State.ControlInterfaceNumber = RNDISControlInterface->InterfaceNumber;
@@ -138,14 +138,12 @@ uint8_t SI_Host_ConfigurePipes(USB_ClassInfo_SI_Host_t* const SIInterfaceInfo,
 			continue;
 		}
 		
-		if (!(Pipe_ConfigurePipe(portnum,PipeNum, Type, Token, EndpointAddress, Size,
-		                         DoubleBanked ? PIPE_BANK_DOUBLE : PIPE_BANK_SINGLE)))
+		/* Interrupt pipes are opened with their interval, so their bandwidth is reserved only in the frames they use */
+		if (!(Pipe_ConfigurePipeInterval(portnum,PipeNum, Type, Token, EndpointAddress, Size,
+		                                 DoubleBanked ? PIPE_BANK_DOUBLE : PIPE_BANK_SINGLE, InterruptPeriod)))
 		{
 			return SI_ENUMERROR_PipeConfigurationFailed;
 		}
-		
-		if (InterruptPeriod)
-		  Pipe_SetInterruptPeriod(InterruptPeriod);
 	}
 
 	SIInterfaceInfo->State.InterfaceNumber = StillImageInterface->InterfaceNumber;
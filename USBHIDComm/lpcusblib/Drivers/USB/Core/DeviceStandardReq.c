@@ -187,7 +187,12 @@ static void USB_Device_SetConfiguration(void)
 	Endpoint_ClearStatusStage();
 
 	if (USB_Device_ConfigurationNumber)
-	  USB_DeviceState = DEVICE_STATE_Configured;
+	{
+		USB_DeviceState = DEVICE_STATE_Configured;
+		#if defined(USB_DEVICE_ENUMERATION_PROBE)
+		USB_Device_EnumerationDone();
+		#endif
+	}
 	else
 	  USB_DeviceState = (USB_Device_IsAddressSet()) ? DEVICE_STATE_Configured : DEVICE_STATE_Powered;
 
@@ -256,7 +261,10 @@ static void USB_Device_GetDescriptor(void)
 
 	Endpoint_ClearSETUP();
 
-	#if defined(USE_RAM_DESCRIPTORS) || !defined(ARCH_HAS_MULTI_ADDRESS_SPACE)
+	#if defined(__LPC17XX__) || defined(__LPC177X_8X__)
+	/* Descriptors are constant, so the data stage is sent straight from them */
+	Endpoint_Write_Control_Direct(DescriptorPointer, DescriptorSize);
+	#elif defined(USE_RAM_DESCRIPTORS) || !defined(ARCH_HAS_MULTI_ADDRESS_SPACE)
 	Endpoint_Write_Control_Stream_LE(DescriptorPointer, DescriptorSize);
 	#elif defined(USE_EEPROM_DESCRIPTORS)
 	Endpoint_Write_Control_EStream_LE(DescriptorPointer, DescriptorSize);
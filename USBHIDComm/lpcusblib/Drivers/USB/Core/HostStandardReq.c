@@ -61,6 +61,10 @@ uint8_t USB_Host_SendControlRequest(const uint8_t corenum, void* const BufferPtr
 		if ((USB_ControlRequest.bmRequestType & CONTROL_REQTYPE_DIRECTION) == REQDIR_DEVICETOHOST)
 		{
 			PipeInfo[corenum][pipeselected[corenum]].ByteTransfered = USB_ControlRequest.wLength;
+
+			if (DataStream == NULL)
+			  return HOST_SENDCONTROL_Successful; /* Caller reads the data stage from the pipe and clears it */
+
 			while(DataLen)
 			{
 				*(DataStream++) = Pipe_Read_8(corenum);
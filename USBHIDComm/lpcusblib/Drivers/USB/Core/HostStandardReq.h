@@ -113,7 +113,9 @@
 			 *  \ingroup Group_PipeControlReq
 			 *
 			 *  \param[in] BufferPtr  Pointer to the start of the data buffer if the request has a data stage, or
-			 *                        \c NULL if the request transfers no data to or from the device.
+			 *                        \c NULL if the request transfers no data to or from the device. For a device to
+			 *                        host request with a data stage, \c NULL leaves the received data in the control
+			 *                        pipe to be read with \ref Pipe_Read_8(), after which \ref Pipe_ClearIN() must be called.
 			 *
 			 *  \return A value from the \ref USB_Host_SendControlErrorCodes_t enum to indicate the result.
 			 */
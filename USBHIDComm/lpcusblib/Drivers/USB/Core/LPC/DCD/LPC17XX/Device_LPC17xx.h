@@ -118,8 +118,139 @@
 				#define INTERNAL_SERIAL_LENGTH_BITS    0
 				#define INTERNAL_SERIAL_START_ADDRESS  0
 			#endif			
-			
+
+			/** Mask for the event word returned by \ref USB_Device_TakeEvents(), set when the given logical endpoint
+			 *  has completed a transfer or is ready for the next one.
+			 *
+			 *  \param[in] EndpointNumber  Logical endpoint number, from 0 to 15.
+			 */
+			#define USB_DEVICE_EVENT_ENDPOINT(EndpointNumber)  (1UL << (16 + (EndpointNumber)))
+
+			/** Mask of all endpoint bits in the event word returned by \ref USB_Device_TakeEvents(). */
+			#define USB_DEVICE_EVENT_ENDPOINTS                 0xFFFF0000UL
+
+			/** Mask of the valid bits of a full speed USB frame number, which wraps every 2048 frames. */
+			#define USB_DEVICE_FRAME_NUMBER_MASK               0x07FF
+
+		/* Enums: */
+			/** Enum for the device events posted by the USB interrupt, as returned by \ref USB_Device_TakeEvents()
+			 *  and \ref USB_Device_WaitForEvents(). Endpoint specific events are reported in addition through the
+			 *  \ref USB_DEVICE_EVENT_ENDPOINT() bits.
+			 */
+			enum USB_Device_Events_t
+			{
+				USB_DEVICE_EVENT_Setup             = (1 << 0), /**< A SETUP packet was received on the control endpoint. */
+				USB_DEVICE_EVENT_EndpointReady     = (1 << 1), /**< An endpoint completed a packet or requested a new DMA
+				                                                *   descriptor.
+				                                                */
+				USB_DEVICE_EVENT_EndOfTransfer     = (1 << 2), /**< A DMA transfer on a non-control endpoint completed. */
+				USB_DEVICE_EVENT_StartOfFrame      = (1 << 3), /**< A Start Of Frame was received, see
+				                                                *   \ref USB_Device_EnableSOFEvents().
+				                                                */
+				USB_DEVICE_EVENT_BusReset          = (1 << 4), /**< The host reset the bus. */
+			};
+
+		/* Type Defines: */
+			#if defined(USB_DEVICE_EVENT_LATENCY_PROBE) || defined(__DOXYGEN__)
+			/** Type define for the event latency probe, measured in CPU cycles from the first event posted by the
+			 *  USB interrupt to the call of \ref USB_Device_TakeEvents() that collects it.
+			 *
+			 *  \note Only available when the \c USB_DEVICE_EVENT_LATENCY_PROBE compile time token is defined; the probe
+			 *        uses the Cortex-M3 DWT cycle counter, which is enabled on USB reset.
+			 */
+			typedef struct
+			{
+				uint32_t Last; /**< Latency of the most recently collected events. */
+				uint32_t Max; /**< Worst latency seen since the probe was last cleared. */
+				uint32_t Count; /**< Number of times events were collected. */
+			} USB_Device_EventLatency_t;
+			#endif
+
+			#if defined(USB_DEVICE_ENUMERATION_PROBE) || defined(__DOXYGEN__)
+			/** Type define for the enumeration time probe, measured in CPU cycles from the last USB bus reset to the
+			 *  SET_CONFIGURATION request that selects a configuration, that is the time the host takes to bring the
+			 *  device to \ref DEVICE_STATE_Configured.
+			 *
+			 *  \note Only available when the \c USB_DEVICE_ENUMERATION_PROBE compile time token is defined; the probe
+			 *        uses the Cortex-M3 DWT cycle counter, which is enabled on USB reset.
+			 */
+			typedef struct
+			{
+				uint32_t Last; /**< Duration of the most recent enumeration. */
+				uint32_t Count; /**< Number of enumerations measured. */
+			} USB_Device_EnumerationTime_t;
+			#endif
+
+			/** Type define for a point in time expressed in the host's frame clock, as returned by
+			 *  \ref USB_Device_GetFrameTime(). One frame lasts 1ms, that is \c SystemCoreClock / 1000 CPU cycles.
+			 */
+			typedef struct
+			{
+				uint16_t FrameNumber; /**< 11-bit number of the frame whose SOF was last received. */
+				uint32_t SubFrameCycles; /**< CPU cycles elapsed since that SOF was handled. */
+			} USB_Device_FrameTime_t;
+
+		/* Global Variables: */
+			#if defined(USB_DEVICE_EVENT_LATENCY_PROBE) || defined(__DOXYGEN__)
+			/** Event latency probe, updated by \ref USB_Device_TakeEvents(). The application may clear it at any time. */
+			extern volatile USB_Device_EventLatency_t USB_Device_EventLatency;
+			#endif
+
+			#if defined(USB_DEVICE_ENUMERATION_PROBE) || defined(__DOXYGEN__)
+			/** Enumeration time probe, updated when the host selects a configuration. The application may clear it at
+			 *  any time.
+			 */
+			extern volatile USB_Device_EnumerationTime_t USB_Device_EnumerationTime;
+			#endif
+
 		/* Function Prototypes: */
+			/** Atomically collects and clears the device events posted by the USB interrupt since the previous call.
+			 *  Class tasks can then be run only for the events that concern them, instead of being polled continuously.
+			 *
+			 *  \return Mask of \ref USB_Device_Events_t values and \ref USB_DEVICE_EVENT_ENDPOINT() bits.
+			 */
+			uint32_t USB_Device_TakeEvents(void) ATTR_WARN_UNUSED_RESULT;
+
+			#if defined(USB_DEVICE_ENUMERATION_PROBE) || defined(__DOXYGEN__)
+			/** Closes the enumeration time measurement started by the last bus reset, called by the standard request
+			 *  handler when a configuration is selected.
+			 */
+			void USB_Device_EnumerationDone(void);
+			#endif
+
+			/** Puts the core to sleep with \c WFI until an interrupt occurs, unless device events are already pending,
+			 *  then collects the pending events. Any interrupt wakes the core, so the returned mask may be empty when the
+			 *  wake-up came from another peripheral; this lets the main loop run its own work on the same wake-up.
+			 *
+			 *  \note Interrupts must be enabled when calling this function, otherwise the USB interrupt cannot run and no
+			 *        event is ever posted.
+			 *
+			 *  \return Mask of \ref USB_Device_Events_t values and \ref USB_DEVICE_EVENT_ENDPOINT() bits.
+			 */
+			uint32_t USB_Device_WaitForEvents(void);
+
+			/** Returns the current time in the host's frame clock: the USB interrupt latches a cycle stamp and counts
+			 *  the frame number on every SOF, and the offset into the frame is taken from the Cortex-M3 DWT cycle
+			 *  counter. The count is realigned on the SIE frame number by \ref USB_Device_TakeEvents() whenever it
+			 *  collects a SOF event, and by \ref USB_Device_GetFrameNumber(). This lets IN reports carry sample timestamps that the host can correlate with its own frame
+			 *  counter, with a resolution of one CPU cycle.
+			 *
+			 *  \note SOF interrupts must be enabled with \ref USB_Device_EnableSOFEvents(), otherwise the latch is not
+			 *        updated and \c SubFrameCycles keeps growing past one frame. The stamp is taken on interrupt entry, so
+			 *        it trails the SOF on the wire by the (roughly constant) interrupt latency.
+			 *
+			 *  \param[out] FrameTime  Pointer to the structure receiving the frame number and the offset into the frame.
+			 */
+			void USB_Device_GetFrameTime(USB_Device_FrameTime_t* const FrameTime) ATTR_NON_NULL_PTR_ARG(1);
+
+			/** Returns the frame number of the last SOF. Unlike \ref USB_Device_GetFrameNumber() this does not
+			 *  issue SIE commands, so it may be called from any context, including other interrupt handlers.
+			 *
+			 *  \return 11-bit USB frame number.
+			 */
+			uint16_t USB_Device_GetSOFFrameNumber(void) ATTR_WARN_UNUSED_RESULT;
+
+
 			/** Sends a Remote Wakeup request to the host. This signals to the host that the device should
 			 *  be taken out of suspended mode, and communications should resume.
 			 *
@@ -141,21 +272,15 @@
 			 */
 			void USB_Device_SendRemoteWakeup(void);
 
-		/* Inline Functions: */
 			/** Returns the current USB frame number, when in device mode. Every millisecond the USB bus is active (i.e. enumerated to a host)
 			 *  the frame number is incremented by one.
+			 *
+			 *  \note Reads the frame number from the SIE with the USB interrupt masked, so it must not be called from
+			 *        the USB interrupt; use \ref USB_Device_GetSOFFrameNumber() there.
 			 */
-			static inline uint16_t USB_Device_GetFrameNumber(void) ATTR_ALWAYS_INLINE ATTR_WARN_UNUSED_RESULT;
-			static inline uint16_t USB_Device_GetFrameNumber(void)
-			{
-				uint32_t val;
-
-				SIE_WriteCommamd(CMD_RD_FRAME);
-				val = SIE_ReadCommandData(DAT_RD_FRAME);
-				val = val | (SIE_ReadCommandData(DAT_RD_FRAME) << 8);
+			uint16_t USB_Device_GetFrameNumber(void) ATTR_WARN_UNUSED_RESULT;
 
-				return (val);
-			}
+		/* Inline Functions: */
 
 			#if !defined(NO_SOF_EVENTS)
 				/** Enables the device mode Start Of Frame events. When enabled, this causes the
@@ -167,7 +292,7 @@
 				static inline void USB_Device_EnableSOFEvents(void) ATTR_ALWAYS_INLINE;
 				static inline void USB_Device_EnableSOFEvents(void)
 				{
-
+					LPC_USB->USBDevIntEn |= FRAME_INT;
 				}
 
 				/** Disables the device mode Start Of Frame events. When disabled, this stops the firing of the
@@ -178,7 +303,7 @@
 				static inline void USB_Device_DisableSOFEvents(void) ATTR_ALWAYS_INLINE;
 				static inline void USB_Device_DisableSOFEvents(void)
 				{
-
+					LPC_USB->USBDevIntEn &= ~FRAME_INT;
 				}
 			#endif
 
@@ -31,18 +31,27 @@
 
 #if (defined(__LPC17XX__)||defined(__LPC177X_8X__)) && defined(USB_CAN_BE_DEVICE)
 #include "../../../Endpoint.h"
+#include "../../../Device.h"
+#include "../../../Events.h"
+#if defined(INTERRUPT_CONTROL_ENDPOINT)
+#include "../../../DeviceStandardReq.h"
+#endif
 
 #define IsOutEndpoint(PhysicalEP)		(! ((PhysicalEP) & 1) )
 
 volatile bool SETUPReceived;
 volatile bool isOutReceived;
 volatile bool isInReady;
+#if defined(INTERRUPT_CONTROL_ENDPOINT)
+volatile bool isControlRequestActive;
+#endif
 
 PRAGMA_ALIGN_128
 uint32_t UDCA[32] __DATA(USBRAM_SECTION) ATTR_ALIGNED(128);
 DMADescriptor dmaDescriptor[USED_PHYSICAL_ENDPOINTS] __DATA(USBRAM_SECTION);
 static uint8_t SetupPackage[8] __DATA(USBRAM_SECTION);
-uint32_t DataInRemainCount,DataInRemainOffset;
+uint32_t DataInRemainCount;
+const uint8_t* DataInRemainPointer;
 bool IsConfigured,shortpacket;
 uint8_t* ISO_Address;
 PRAGMA_ALIGN_4
@@ -51,6 +60,29 @@ PRAGMA_WEAK(CALLBACK_HAL_GetISOBufferAddress,Dummy_EPGetISOAddress)
 uint32_t CALLBACK_HAL_GetISOBufferAddress(const uint32_t EPNum,uint32_t* last_packet_size) ATTR_WEAK ATTR_ALIAS(Dummy_EPGetISOAddress);
 uint32_t BufferAddressIso[32] __DATA(USBRAM_SECTION);
 uint32_t SizeAudioTransfer;
+static volatile uint32_t PendingEvents;
+static volatile uint16_t SOFFrameNumber;	/* Counted by the USB interrupt, realigned on the SIE frame number by SyncSOFFrameNumber() */
+static volatile uint32_t SOFCycles;
+#if defined(USB_DEVICE_EVENT_LATENCY_PROBE)
+static uint32_t PendingEventsTime;
+volatile USB_Device_EventLatency_t USB_Device_EventLatency;
+#endif
+#if defined(USB_DEVICE_ENUMERATION_PROBE)
+static uint32_t BusResetTime;
+volatile USB_Device_EnumerationTime_t USB_Device_EnumerationTime;
+#endif
+
+/* Posts device events, only called from the USB interrupt */
+static inline void PostEvents(uint32_t Events)
+{
+#if defined(USB_DEVICE_EVENT_LATENCY_PROBE)
+	if (PendingEvents == 0)
+	{
+		PendingEventsTime = DWT->CYCCNT;
+	}
+#endif
+	PendingEvents |= Events;
+}
 
 /*
  *  Write Command
@@ -100,6 +132,10 @@ void HAL_Reset (void)
 {
 	uint32_t n;
 
+	/* Cycle counter for the SOF timestamps and the event latency probe */
+	CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+	DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+
 	LPC_USB->USBEpInd = 0;
 	LPC_USB->USBMaxPSize = USB_Device_ControlEndpointSize;
 	LPC_USB->USBEpInd = 1;
@@ -179,7 +215,7 @@ bool Endpoint_ConfigureEndpoint(const uint8_t Number, const uint8_t Type,
 	{
 		LPC_USB->USBEpIntEn |= (1 << PhyEP);
 		DataInRemainCount = 0;
-		DataInRemainOffset = 0;
+		DataInRemainPointer = NULL;
 	}else /* all other endpoints use DMA mode */
 	{
 		memset(&dmaDescriptor[PhyEP], 0, sizeof(DMADescriptor));
@@ -234,7 +270,7 @@ void ReadControlEndpoint( uint8_t *pData )
  * @param
  * @return
  *********************************************************************/
-void WriteControlEndpoint( uint8_t *pData, uint32_t cnt )
+void WriteControlEndpoint( const uint8_t *pData, uint32_t cnt )
 {
 	uint32_t n;
 	uint32_t count;
@@ -248,20 +284,20 @@ void WriteControlEndpoint( uint8_t *pData, uint32_t cnt )
 		}
 		count = USB_Device_ControlEndpointSize;
 		DataInRemainCount = cnt - USB_Device_ControlEndpointSize;
-		DataInRemainOffset += count;
+		DataInRemainPointer = pData + count;
 	}
 	else
 	{
 		count = cnt;
 		DataInRemainCount = 0;
-		DataInRemainOffset = 0;
+		DataInRemainPointer = NULL;
 	}
 	LPC_USB->USBCtrl = CTRL_WR_EN;
 	LPC_USB->USBTxPLen = count;
 
 	for (n = 0; n < (count + 3) / 4; n++)
 	{
-		LPC_USB->USBTxData = *((uint32_t *)pData);
+		LPC_USB->USBTxData = *((const uint32_t *)pData);
 		pData += 4;
 	}
 
@@ -271,6 +307,146 @@ void WriteControlEndpoint( uint8_t *pData, uint32_t cnt )
 	SIE_WriteCommamd(CMD_VALID_BUF);
 }
 
+/********************************************************************//**
+ * @brief	Starts a control IN data stage straight from a caller supplied
+ *			buffer. Only the first packet is written here, the rest of the
+ *			buffer is fed to the endpoint one packet at a time from the
+ *			control IN endpoint interrupt.
+ * @param	Buffer	Data to send, must stay valid until the data stage ends
+ * @param	Length	Number of bytes to send
+ * @return	ENDPOINT_RWCSTREAM_NoError, or ENDPOINT_RWCSTREAM_HostAborted if
+ *			the previous data stage did not end within USB_STREAM_TIMEOUT_MS,
+ *			in which case the request is stalled
+ *********************************************************************/
+uint8_t Endpoint_Write_Control_Direct(const void* const Buffer, uint16_t Length)
+{
+	USB_Timer_Countdown_t Timeout;
+
+	/* Runs from the USB interrupt with INTERRUPT_CONTROL_ENDPOINT, so it is timed on SysTick, not on the tick */
+	USB_Timer_StartCountdown(&Timeout, USB_STREAM_TIMEOUT_MS * 1000);
+	while (!Endpoint_IsINReady()) /*-- Wait for the previous data stage --*/
+	{
+		if (USB_Timer_CountdownExpired(&Timeout))
+		{
+			Endpoint_StallTransaction();
+			return ENDPOINT_RWCSTREAM_HostAborted;
+		}
+	}
+
+	usb_data_buffer_index = 0;
+	usb_data_buffer_size = 0;
+	WriteControlEndpoint((const uint8_t*)Buffer, MIN(Length, USB_ControlRequest.wLength));
+
+	return ENDPOINT_RWCSTREAM_NoError;
+}
+
+/* Realigns the SOF frame count on the SIE frame number. The SIE command and its data reads must not be
+ * split by the USB interrupt, so this runs in thread context with the USB interrupt masked */
+static void SyncSOFFrameNumber(void)
+{
+	uint32_t IrqEnabled = NVIC->ISER[((uint32_t) USB_IRQn) >> 5] & (1UL << (((uint32_t) USB_IRQn) & 0x1F));
+	uint32_t FrameNumber;
+
+	NVIC_DisableIRQ(USB_IRQn);
+	SIE_WriteCommamd(CMD_RD_FRAME);
+	FrameNumber = SIE_ReadCommandData(DAT_RD_FRAME);
+	FrameNumber |= (SIE_ReadCommandData(DAT_RD_FRAME) << 8);
+
+	/* A SOF the interrupt has not handled yet is already in the SIE frame number, the interrupt will count it */
+	if (LPC_USB->USBDevIntSt & LPC_USB->USBDevIntEn & FRAME_INT)
+	{
+		FrameNumber--;
+	}
+	SOFFrameNumber = FrameNumber & USB_DEVICE_FRAME_NUMBER_MASK;
+
+	if (IrqEnabled)
+	{
+		NVIC_EnableIRQ(USB_IRQn);
+	}
+}
+
+/********************************************************************//**
+ * @brief
+ * @param
+ * @return
+ *********************************************************************/
+uint32_t USB_Device_TakeEvents(void)
+{
+	uint32_t CurrentPriMask = __get_PRIMASK();
+	uint32_t Events;
+
+	__disable_irq();
+	Events = PendingEvents;
+	PendingEvents = 0;
+#if defined(USB_DEVICE_EVENT_LATENCY_PROBE)
+	if (Events)
+	{
+		uint32_t Latency = DWT->CYCCNT - PendingEventsTime;
+
+		USB_Device_EventLatency.Last = Latency;
+		if (Latency > USB_Device_EventLatency.Max)
+		{
+			USB_Device_EventLatency.Max = Latency;
+		}
+		USB_Device_EventLatency.Count++;
+	}
+#endif
+	__set_PRIMASK(CurrentPriMask);
+
+	if (Events & USB_DEVICE_EVENT_StartOfFrame)
+	{
+		SyncSOFFrameNumber();
+	}
+
+	return Events;
+}
+
+uint32_t USB_Device_WaitForEvents(void)
+{
+	uint32_t CurrentPriMask = __get_PRIMASK();
+
+	/* WFI still wakes up on a pending interrupt while masked, so an event posted
+	 * between the check and the sleep cannot be missed */
+	__disable_irq();
+	if (PendingEvents == 0)
+	{
+		__WFI();
+	}
+	__set_PRIMASK(CurrentPriMask);
+
+	return USB_Device_TakeEvents();
+}
+
+void USB_Device_GetFrameTime(USB_Device_FrameTime_t* const FrameTime)
+{
+	uint32_t CurrentPriMask = __get_PRIMASK();
+
+	/* Both values must come from the same SOF */
+	__disable_irq();
+	FrameTime->FrameNumber = SOFFrameNumber;
+	FrameTime->SubFrameCycles = DWT->CYCCNT - SOFCycles;
+	__set_PRIMASK(CurrentPriMask);
+}
+
+#if defined(USB_DEVICE_ENUMERATION_PROBE)
+void USB_Device_EnumerationDone(void)
+{
+	USB_Device_EnumerationTime.Last = DWT->CYCCNT - BusResetTime;
+	USB_Device_EnumerationTime.Count++;
+}
+#endif
+
+uint16_t USB_Device_GetSOFFrameNumber(void)
+{
+	return SOFFrameNumber;
+}
+
+uint16_t USB_Device_GetFrameNumber(void)
+{
+	SyncSOFFrameNumber();
+	return SOFFrameNumber;
+}
+
 /********************************************************************//**
  * @brief
  * @param
@@ -296,6 +472,39 @@ void Endpoint_GetSetupPackage(uint8_t* pData)
 	memcpy(pData, SetupPackage, 8);
 }
 
+#if defined(INTERRUPT_CONTROL_ENDPOINT)
+/********************************************************************//**
+ * @brief	Processes the received SETUP packet(s) from the USB interrupt.
+ *			The endpoint selected by the interrupted code is saved and
+ *			restored, and a SETUP packet received while a request is
+ *			already being processed (the endpoint ISR is polled from the
+ *			control endpoint wait loops) is left for the outer call.
+ * @param	None
+ * @return	None
+ *********************************************************************/
+static void ControlEndpointISR(void)
+{
+	uint8_t PrevEndpoint;
+
+	if (isControlRequestActive)
+	{
+		return;
+	}
+	isControlRequestActive = true;
+
+	PrevEndpoint = Endpoint_GetCurrentEndpoint();
+	Endpoint_SelectEndpoint(ENDPOINT_CONTROLEP);
+
+	while (SETUPReceived && (USB_DeviceState != DEVICE_STATE_Unattached))
+	{
+		USB_Device_ProcessControlRequest();
+	}
+
+	Endpoint_SelectEndpoint(PrevEndpoint);
+	isControlRequestActive = false;
+}
+#endif
+
 void SlaveEndpointISR() 
 {
 	uint32_t PhyEP;
@@ -316,30 +525,40 @@ void SlaveEndpointISR()
 				{
 					SETUPReceived = true;
 					ReadControlEndpoint(SetupPackage);
+					PostEvents(USB_DEVICE_EVENT_Setup);
 				}else
 				{
 					ReadControlEndpoint(usb_data_buffer);
+					PostEvents(USB_DEVICE_EVENT_EndpointReady | USB_DEVICE_EVENT_ENDPOINT(ENDPOINT_CONTROLEP));
 				}
 			}
 			else                              /* IN Endpoint */
 			{
 				isInReady = true;
+				PostEvents(USB_DEVICE_EVENT_EndpointReady | USB_DEVICE_EVENT_ENDPOINT(ENDPOINT_CONTROLEP));
 				if(DataInRemainCount)
 				{
-					WriteControlEndpoint((uint8_t*)(usb_data_buffer+DataInRemainOffset),DataInRemainCount);
+					WriteControlEndpoint(DataInRemainPointer,DataInRemainCount);
 				}
 				else
 				{
 					if(shortpacket)
 					{
 						shortpacket = false;
-						WriteControlEndpoint((uint8_t*)(usb_data_buffer+DataInRemainOffset),DataInRemainCount);
-						DataInRemainOffset = 0;
+						WriteControlEndpoint(DataInRemainPointer,DataInRemainCount);
+						DataInRemainPointer = NULL;
 					}
 				}
 			}
 		}
 	}
+
+#if defined(INTERRUPT_CONTROL_ENDPOINT)
+	if (SETUPReceived)
+	{
+		ControlEndpointISR();
+	}
+#endif
 }
 
 void Endpoint_Streaming(uint8_t * buffer,uint16_t packetsize,
@@ -420,6 +639,7 @@ void DMAEndTransferISR()
 	{
 		if ( EoTIntSt & (1 << PhyEP))
 		{
+			PostEvents(USB_DEVICE_EVENT_EndOfTransfer | USB_DEVICE_EVENT_ENDPOINT(PhyEP / 2));
 			if ( IsOutEndpoint(PhyEP) )                 /* OUT Endpoint */
 			{
 				if(dmaDescriptor[PhyEP].Isochronous == 1) // iso endpoint
@@ -451,6 +671,7 @@ void DMANewTransferRequestISR()
 	{
 		if ( NDDRIntSt & (1 << PhyEP))
 		{
+			PostEvents(USB_DEVICE_EVENT_EndpointReady | USB_DEVICE_EVENT_ENDPOINT(PhyEP / 2));
 			if ( IsOutEndpoint(PhyEP) )                     /* OUT Endpoint */
 			{
 				if(dmaDescriptor[PhyEP].Isochronous == 1) // iso endpoint
@@ -527,7 +748,11 @@ void DcdIrqHandler (uint8_t DeviceID)
 		if (SIEDeviceStatus & DEV_RST)	                    /* Reset */
 		{
 			HAL_Reset();
+#if defined(USB_DEVICE_ENUMERATION_PROBE)
+			BusResetTime = DWT->CYCCNT; /* HAL_Reset() has started the cycle counter */
+#endif
 			USB_DeviceState = DEVICE_STATE_Default;
+			PostEvents(USB_DEVICE_EVENT_BusReset);
 			Endpoint_ConfigureEndpoint(ENDPOINT_CONTROLEP, 0, ENDPOINT_DIR_OUT, USB_Device_ControlEndpointSize,0);
 			Endpoint_ConfigureEndpoint(ENDPOINT_CONTROLEP, 0, ENDPOINT_DIR_IN, USB_Device_ControlEndpointSize,0);
 		}
@@ -547,7 +772,14 @@ void DcdIrqHandler (uint8_t DeviceID)
 
 	if (DevIntSt & FRAME_INT)
 	{
-
+		/* No SIE command here: thread context may be between an SIE command and its data read */
+		SOFCycles = DWT->CYCCNT;
+		SOFFrameNumber = (SOFFrameNumber + 1) & USB_DEVICE_FRAME_NUMBER_MASK;
+
+		PostEvents(USB_DEVICE_EVENT_StartOfFrame);
+#if !defined(NO_SOF_EVENTS)
+		EVENT_USB_Device_StartOfFrame();
+#endif
 	}
 
 	if (DevIntSt & ERR_INT)
@@ -96,13 +96,33 @@
 
 			extern volatile bool isOutReceived;
 			extern volatile bool isInReady;
+			#if defined(INTERRUPT_CONTROL_ENDPOINT)
+			extern volatile bool isControlRequestActive;
+			#endif
+
+			void SlaveEndpointISR(void);
 
-			void WriteControlEndpoint(uint8_t *pData, uint32_t cnt);
+			void WriteControlEndpoint(const uint8_t *pData, uint32_t cnt);
 			void ReadControlEndpoint(uint8_t *pData);
 			void DcdDataTransfer(uint8_t PhyEP, uint8_t *pData, uint32_t cnt);
 			void Endpoint_Streaming(uint8_t * buffer,uint16_t packetsize,
 						uint16_t totalpackets,uint16_t dummypackets);
 		/* Inline Functions: */
+			/* Queues Length bytes from Buffer on the given physical IN endpoint. Only the endpoint's own DMA
+			 * descriptor and UDCA entry are written, so this may be called from any context. */
+			static inline void Endpoint_SubmitIN_Prv(const uint8_t PhyEP, uint8_t* const Buffer, const uint16_t Length) ATTR_ALWAYS_INLINE;
+			static inline void Endpoint_SubmitIN_Prv(const uint8_t PhyEP, uint8_t* const Buffer, const uint16_t Length)
+			{
+				DcdDataTransfer(PhyEP, Buffer, Length);
+				LPC_USB->USBDMARSet = (1 << PhyEP);
+			}
+
+			/* Returns true once the DMA engine has finished with the last buffer queued on the physical endpoint. */
+			static inline bool Endpoint_IsDMARetired_Prv(const uint8_t PhyEP) ATTR_WARN_UNUSED_RESULT ATTR_ALWAYS_INLINE;
+			static inline bool Endpoint_IsDMARetired_Prv(const uint8_t PhyEP)
+			{
+				return ((volatile DMADescriptor*)&dmaDescriptor[PhyEP])->Retired;
+			}
 
 		/* Function Prototypes: */
 			void Endpoint_ClearEndpoints(void);
@@ -112,6 +132,24 @@
 
 	#endif
 
+		/* Type Defines: */
+			/** Type define for an IN endpoint handle. A handle carries its own packet buffer and write position
+			 *  instead of relying on the globally selected endpoint and the shared endpoint buffers, so each
+			 *  producer (including one running in interrupt context) can fill and send packets on its endpoint
+			 *  without locking out the main loop's use of the selected endpoint API.
+			 *
+			 *  \note A handle must only be used by one context at a time; use one handle per producer.
+			 *
+			 *  \ingroup Group_EndpointRW_LPC17xx
+			 */
+			typedef struct
+			{
+				uint8_t           PhysicalEndpoint; /**< Physical endpoint the handle sends on. */
+				uint8_t*          Buffer; /**< Packet buffer, read by the USB DMA engine. */
+				uint16_t          BufferSize; /**< Size of \c Buffer in bytes. */
+				volatile uint16_t Length; /**< Number of bytes written since the last \ref EP_Submit(). */
+			} Endpoint_Handle_t;
+
 		/* Inline Functions: */
 			/** Configures the specified endpoint number with the given endpoint type, direction, bank size
 			 *  and banking mode. Once configured, the endpoint may be read from or written to, depending
@@ -295,12 +333,15 @@
 			{
 				if (endpointselected==ENDPOINT_CONTROLEP)
 				{
-
+					#if defined(INTERRUPT_CONTROL_ENDPOINT)
+					if (isControlRequestActive) /* Running from the USB interrupt, poll for completion */
+					  SlaveEndpointISR();
+					#endif
 					return isInReady;
 				}else
 				{
 					uint8_t SelEP_Data;
-					if (dmaDescriptor[ endpointhandle[endpointselected] ].Retired == true){
+					if (Endpoint_IsDMARetired_Prv(endpointhandle[endpointselected])){
 						SIE_WriteCommamd( CMD_SEL_EP(endpointhandle[endpointselected]) );
 						SelEP_Data = SIE_ReadCommandData( DAT_SEL_EP(endpointhandle[endpointselected]) ) ;
 						if((SelEP_Data & 1) == 0)
@@ -322,7 +363,10 @@
 			{
 				if (endpointselected==ENDPOINT_CONTROLEP)
 				{
-
+					#if defined(INTERRUPT_CONTROL_ENDPOINT)
+					if (isControlRequestActive) /* Running from the USB interrupt, poll for completion */
+					  SlaveEndpointISR();
+					#endif
 					return isOutReceived;
 				}else
 				{
@@ -378,8 +422,7 @@
 					usb_data_buffer_size = 0;
 				}else
 				{
-					DcdDataTransfer(PhyEP, usb_data_buffer_IN, usb_data_buffer_IN_index);
-					LPC_USB->USBDMARSet = (1 << PhyEP);
+					Endpoint_SubmitIN_Prv(PhyEP, usb_data_buffer_IN, usb_data_buffer_IN_index);
 					usb_data_buffer_IN_index = 0;
 				}
 			}
@@ -460,6 +503,90 @@
 			{
 			}
 
+			/** Binds an endpoint handle to a configured IN endpoint and its packet buffer. The endpoint must have been
+			 *  configured with \ref Endpoint_ConfigureEndpoint() before the handle is opened.
+			 *
+			 *  \ingroup Group_EndpointRW_LPC17xx
+			 *
+			 *  \param[out] Handle      Handle to initialize.
+			 *  \param[in]  Number      Logical number of the IN endpoint.
+			 *  \param[in]  Buffer      Packet buffer owned by the handle. It is read by the USB DMA engine, so it should be
+			 *                          placed in USB RAM (\c __DATA(USBRAM_SECTION)) and be word aligned.
+			 *  \param[in]  BufferSize  Size of \c Buffer in bytes.
+			 */
+			static inline void EP_Open(Endpoint_Handle_t* const Handle,
+			                           const uint8_t Number,
+			                           uint8_t* const Buffer,
+			                           const uint16_t BufferSize) ATTR_NON_NULL_PTR_ARG(1) ATTR_NON_NULL_PTR_ARG(3) ATTR_ALWAYS_INLINE;
+			static inline void EP_Open(Endpoint_Handle_t* const Handle,
+			                           const uint8_t Number,
+			                           uint8_t* const Buffer,
+			                           const uint16_t BufferSize)
+			{
+				Handle->PhysicalEndpoint = endpointhandle[Number];
+				Handle->Buffer           = Buffer;
+				Handle->BufferSize       = BufferSize;
+				Handle->Length           = 0;
+			}
+
+			/** Determines if the handle's buffer may be written. This is the case once the USB DMA engine has moved the
+			 *  previously submitted packet into the endpoint; the endpoint itself holds that packet until the host reads
+			 *  it, and a packet submitted meanwhile is queued behind it by the hardware.
+			 *
+			 *  \ingroup Group_EndpointRW_LPC17xx
+			 *
+			 *  \param[in] Handle  Handle of the IN endpoint.
+			 *
+			 *  \return Boolean \c true if \ref EP_Write() and \ref EP_Submit() may be used, \c false otherwise.
+			 */
+			static inline bool EP_IsReady(const Endpoint_Handle_t* const Handle) ATTR_NON_NULL_PTR_ARG(1) ATTR_WARN_UNUSED_RESULT ATTR_ALWAYS_INLINE;
+			static inline bool EP_IsReady(const Endpoint_Handle_t* const Handle)
+			{
+				return Endpoint_IsDMARetired_Prv(Handle->PhysicalEndpoint);
+			}
+
+			/** Appends data to the handle's next packet. Data that does not fit in the handle's buffer is not copied.
+			 *
+			 *  \ingroup Group_EndpointRW_LPC17xx
+			 *
+			 *  \param[in,out] Handle  Handle of the IN endpoint, which must be ready (see \ref EP_IsReady()).
+			 *  \param[in]     Buffer  Data to append.
+			 *  \param[in]     Length  Number of bytes to append.
+			 *
+			 *  \return Number of bytes appended.
+			 */
+			static inline uint16_t EP_Write(Endpoint_Handle_t* const Handle,
+			                                const void* const Buffer,
+			                                uint16_t Length) ATTR_NON_NULL_PTR_ARG(1) ATTR_ALWAYS_INLINE;
+			static inline uint16_t EP_Write(Endpoint_Handle_t* const Handle,
+			                                const void* const Buffer,
+			                                uint16_t Length)
+			{
+				uint16_t Offset = Handle->Length;
+
+				if (Length > (Handle->BufferSize - Offset))
+				  Length = (Handle->BufferSize - Offset);
+
+				memcpy(&Handle->Buffer[Offset], Buffer, Length);
+				Handle->Length = Offset + Length;
+
+				return Length;
+			}
+
+			/** Sends the data written to the handle since the last submission, and starts a new packet. Submitting
+			 *  without any data written sends a zero length packet.
+			 *
+			 *  \ingroup Group_EndpointRW_LPC17xx
+			 *
+			 *  \param[in,out] Handle  Handle of the IN endpoint, which must be ready (see \ref EP_IsReady()).
+			 */
+			static inline void EP_Submit(Endpoint_Handle_t* const Handle) ATTR_NON_NULL_PTR_ARG(1) ATTR_ALWAYS_INLINE;
+			static inline void EP_Submit(Endpoint_Handle_t* const Handle)
+			{
+				Endpoint_SubmitIN_Prv(Handle->PhysicalEndpoint, Handle->Buffer, Handle->Length);
+				Handle->Length = 0;
+			}
+
 		/* External Variables: */
 			/** Global indicating the maximum packet size of the default control endpoint located at address
 			 *  0 in the device. This value is set to the value indicated in the device descriptor in the user
@@ -500,6 +627,29 @@
 			 */
 			uint8_t Endpoint_WaitUntilReady(void);
 
+			/** Sends the data stage of a control IN request directly from the given buffer, without first
+			 *  copying it into the control endpoint bank. The first packet is loaded immediately; each
+			 *  following packet (and a terminating zero length packet if required) is loaded from the
+			 *  control IN endpoint interrupt as the host acknowledges the previous one, so the call
+			 *  returns as soon as the first packet is queued. The length is clipped to the host's
+			 *  requested \c wLength. If the endpoint is still busy with a previous data stage after
+			 *  \ref USB_STREAM_TIMEOUT_MS, the request is stalled rather than waiting on a host that no
+			 *  longer takes IN packets.
+			 *
+			 *  \note The buffer must remain valid and unchanged until the data stage has completed, which
+			 *        makes this suited to constant data such as the device descriptors. Buffers on the stack
+			 *        should be sent with \ref Endpoint_Write_Control_Stream_LE() instead.
+			 *
+			 *  \ingroup Group_EndpointRW_LPC17xx
+			 *
+			 *  \param[in] Buffer  Pointer to the data to send.
+			 *  \param[in] Length  Number of bytes to send.
+			 *
+			 *  \return A value from the \ref Endpoint_ControlStream_RW_ErrorCodes_t enum.
+			 */
+			uint8_t Endpoint_Write_Control_Direct(const void* const Buffer,
+			                                   uint16_t Length) ATTR_NON_NULL_PTR_ARG(1);
+
 	/* Disable C linkage for C++ Compilers: */
 		#if defined(__cplusplus)
 			}
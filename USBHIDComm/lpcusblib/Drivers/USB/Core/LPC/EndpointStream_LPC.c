@@ -47,10 +47,14 @@ uint8_t Endpoint_Null_Stream(uint16_t Length,
                              uint16_t* const BytesProcessed)
 {
 	uint32_t i;
+	USB_Timer_Countdown_t Timeout;
 
+	/* Not a tick deadline, this also runs from the USB interrupt which blocks the tick */
+	USB_Timer_StartCountdown(&Timeout, USB_STREAM_TIMEOUT_MS * 1000);
 	while ( !Endpoint_IsINReady() ) /*-- Wait until ready --*/
 	{
-		Delay_MS(2);
+		if (USB_Timer_CountdownExpired(&Timeout))
+		  return ENDPOINT_RWSTREAM_Timeout;
 	}
 	for (i=0; i < Length; i++)
 	{
@@ -63,10 +67,14 @@ uint8_t Endpoint_Write_Stream_LE(const void* const Buffer,
 			                                 uint16_t* const BytesProcessed)
 {
 	uint16_t i;
+	USB_Timer_Countdown_t Timeout;
 
+	/* Reached from the USB interrupt through Endpoint_Write_Control_Stream_LE() */
+	USB_Timer_StartCountdown(&Timeout, USB_STREAM_TIMEOUT_MS * 1000);
 	while ( !Endpoint_IsINReady() ) /*-- Wait until ready --*/
 	{
-		Delay_MS(2);
+		if (USB_Timer_CountdownExpired(&Timeout))
+		  return ENDPOINT_RWSTREAM_Timeout;
 	}
 	for(i=0;i<Length;i++)
 	{
@@ -37,6 +37,7 @@
 #include "../../../USBMode.h"
 
 #define USBRAM_SECTION	RAM2
+#define USBRAM2_SECTION	RAM3
 
 #if defined(__LPC177X_8X__)
 /** This macro used in Keil only to declare a variable in a defined section. */
@@ -42,6 +42,13 @@
 PRAGMA_ALIGN_32
 EHCI_HOST_DATA_Type ehci_data[MAX_USB_CORE] __BSS(USBRAM_SECTION);
 //EHCI_HOST_DATA_Type ehci_data __BSS(USBRAM_SECTION);
+
+/* Free descriptors of ehci_data, indexed like HcdQHD(), HcdQTD(), HcdHsITD() and HcdSITD() */
+static HCD_POOL QhdPool[MAX_USB_CORE], QtdPool[MAX_USB_CORE], HsItdPool[MAX_USB_CORE], SItdPool[MAX_USB_CORE];
+static uint32_t QhdFreeMap[MAX_USB_CORE][HCD_POOL_WORDS(HCD_MAX_QHD)];
+static uint32_t QtdFreeMap[MAX_USB_CORE][HCD_POOL_WORDS(HCD_MAX_QTD)];
+static uint32_t HsItdFreeMap[MAX_USB_CORE][HCD_POOL_WORDS(HCD_MAX_HS_ITD)];
+static uint32_t SItdFreeMap[MAX_USB_CORE][HCD_POOL_WORDS(HCD_MAX_SITD)];
 PRAGMA_ALIGN_4096
 NextLinkPointer	PeriodFrameList0[FRAME_LIST_SIZE] ATTR_ALIGNED(4096) __DATA(USBRAM_SECTION);		/* Period Frame List */
 PRAGMA_ALIGN_4096
@@ -72,8 +79,7 @@ HCD_STATUS HcdRhPortDisable(uint8_t HostID, uint8_t PortNum)
 }
 HCD_STATUS HcdRhPortReset(uint8_t HostID, uint8_t uPortNumber)
 {
-	HcdDelayMS(PORT_RESET_PERIOD_MS);
-
+	/* The guard delays around the reset are non blocking waits of the host state machine, see HOST_PORT_RESET_GUARD_MS */
 	USB_REG(HostID)->PORTSC1_H &= ~EHC_PORTSC_PortEnable;	/* Disable Port first */
 	USB_REG(HostID)->PORTSC1_H |= EHC_PORTSC_PortReset; /* Reset port */
 
@@ -82,7 +88,6 @@ HCD_STATUS HcdRhPortReset(uint8_t HostID, uint8_t uPortNumber)
 
 	/* PortEnable is always set - Deviation from EHCI */
 
-	HcdDelayMS(PORT_RESET_PERIOD_MS);
 	return HCD_STATUS_OK;
 }
 
@@ -90,6 +95,15 @@ HCD_STATUS HcdClearEndpointHalt(uint32_t PipeHandle) // FIXME not implemented
 {
 	return HCD_STATUS_OK;
 }
+HCD_STATUS HcdSetPipeInterval(uint32_t PipeHandle, uint8_t Interval) /* Interrupt QHDs are all polled from the 1 ms head, only the interval is recorded */
+{
+	uint8_t HostID, HeadIdx;
+	HCD_TRANSFER_TYPE XferType;
+
+	ASSERT_STATUS_OK( PipehandleParse(PipeHandle, &HostID, &XferType, &HeadIdx) );
+	HcdQHD(HostID,HeadIdx)->Interval = Interval;
+	return HCD_STATUS_OK;
+}
 uint32_t   HcdGetFrameNumber(uint8_t HostID)
 {
 	return USB_REG(HostID)->FRINDEX_H;
@@ -429,14 +443,16 @@ static void FreeQhd(uint8_t HostID, uint8_t QhdIdx )
 	HcdQHD(HostID,QhdIdx)->status = HCD_STATUS_STRUCTURE_IS_FREE;
 	HcdQHD(HostID,QhdIdx)->Horizontal.Link |= LINK_TERMINATE;
 	HcdQHD(HostID,QhdIdx)->inUse = 0;
+	HcdPoolFree(&QhdPool[HostID], QhdIdx);
 }
 static HCD_STATUS AllocQhd(uint8_t HostID, uint8_t DeviceAddr, HCD_USB_SPEED DeviceSpeed, uint8_t EndpointNumber, HCD_TRANSFER_TYPE TransferType, HCD_TRANSFER_DIR TransferDir, uint16_t MaxPacketSize, uint8_t Interval, uint8_t Mult, uint8_t HSHubDevAddr, uint8_t HSHubPortNum, uint32_t* pQhdIdx )
 {
 	/* Looking for a free QHD */
-	for ( (*pQhdIdx)=0; (*pQhdIdx) < HCD_MAX_QTD && HcdQHD(HostID,*pQhdIdx)->inUse; (*pQhdIdx)++) {}
+	int32_t QhdIdx = HcdPoolAlloc(&QhdPool[HostID]);
 
-	if ((*pQhdIdx) == HCD_MAX_QTD )
+	if (QhdIdx < 0)
 		return HCD_STATUS_NOT_ENOUGH_ENDPOINT;
+	*pQhdIdx = (uint32_t) QhdIdx;
 
 	memset(HcdQHD(HostID,*pQhdIdx), 0, sizeof(HCD_QHD) );
 
@@ -506,20 +522,24 @@ static HCD_STATUS RemoveQueueHead(uint8_t HostID, uint8_t QhdIdx )
 /*---------- Queue TD Routines ----------*/
 static void FreeQtd( PHCD_QTD pQtd )
 {
+	uint8_t HostID = HostOfDescriptor(pQtd);
+
 	pQtd->NextQtd |= LINK_TERMINATE;
 	pQtd->inUse = 0;
+	HcdPoolFree(&QtdPool[HostID], pQtd - HcdQTD(HostID,0));
 }
 
 /** Direction, DataToggle parameter only has meaning for control transfer, for other transfer use 0 for these paras */
 static HCD_STATUS AllocQTD (uint8_t HostID, uint32_t* pTdIdx, uint8_t* const BufferPointer, uint32_t xferLen, HCD_TRANSFER_DIR PIDCode, uint8_t DataToggle, uint8_t IOC)
 {
-	for((*pTdIdx) =0; (*pTdIdx) < HCD_MAX_QTD && HcdQTD(HostID,*pTdIdx)->inUse; (*pTdIdx)++) {}
+	int32_t TdIdx = HcdPoolAlloc(&QtdPool[HostID]);
 
-	if ((*pTdIdx) < HCD_MAX_QTD)
+	if (TdIdx >= 0)
 	{
 		uint8_t idx=1;
 		uint32_t BytesInPage;
 
+		*pTdIdx = (uint32_t) TdIdx;
 		memset(HcdQTD(HostID,*pTdIdx), 0, sizeof(HCD_QTD));
 
 		HcdQTD(HostID,*pTdIdx)->NextQtd = 1;
@@ -590,21 +610,24 @@ static HCD_STATUS QueueQTDs (uint32_t* pTdIdx, uint8_t* dataBuff, uint32_t xferL
 /*---------- High Speed ITD Routines ----------*/
 static void FreeHsItd( PHCD_HS_ITD pItd )
 {
+	uint8_t HostID = HostOfDescriptor(pItd);
+
 	pItd->Horizontal.Link |= LINK_TERMINATE;
 	pItd->inUse = 0;
+	HcdPoolFree(&HsItdPool[HostID], pItd - HcdHsITD(HostID,0));
 }
 
 HCD_STATUS AllocHsItd(uint8_t HostID, uint32_t* pTdIdx, uint8_t IhdIdx, uint8_t* dataBuff, uint32_t TDLen, uint8_t XactPerITD, uint8_t IntOnComplete )
 {
-	for((*pTdIdx) =0; (*pTdIdx) < HCD_MAX_HS_ITD && HcdHsITD(HostID,*pTdIdx)->inUse; (*pTdIdx)++)
-	{
-	}
-	if ((*pTdIdx) < HCD_MAX_HS_ITD)
+	int32_t TdIdx = HcdPoolAlloc(&HsItdPool[HostID]);
+
+	if (TdIdx >= 0)
 	{
 		uint8_t i;
 		uint8_t XactStep = 8 / XactPerITD ;
 		uint32_t MaxXactLen = HcdQHD(HostID,IhdIdx)->MaxPackageSize * HcdQHD(HostID,IhdIdx)->Mult;
 
+		*pTdIdx = (uint32_t) TdIdx;
 		memset(HcdHsITD(HostID,*pTdIdx), 0, sizeof(HCD_HS_ITD));
 
 		HcdHsITD(HostID,*pTdIdx)->inUse = 1;
@@ -690,8 +713,11 @@ static HCD_STATUS QueueITDs( uint8_t HostID, uint8_t IhdIdx, uint8_t* dataBuff,
 /*---------- Full Speed ISO routines ----------*/
 static void FreeSItd( PHCD_SITD pSItd ) 
 {
+	uint8_t HostID = HostOfDescriptor(pSItd);
+
 	pSItd->Horizontal.Link |= LINK_TERMINATE;
 	pSItd->inUse = 0;
+	HcdPoolFree(&SItdPool[HostID], pSItd - HcdSITD(HostID,0));
 }
 
 static HCD_STATUS AllocSItd(uint8_t HostID, uint32_t* pTdIdx, uint8_t HeadIdx, uint8_t* dataBuff, uint32_t TDLen, uint8_t IntOnComplete )
@@ -699,12 +725,13 @@ static HCD_STATUS AllocSItd(uint8_t HostID, uint32_t* pTdIdx, uint8_t HeadIdx, u
 #define TCount_Pos 0
 #define TPos_Pos 3
 
-	for((*pTdIdx) =0; (*pTdIdx) < HCD_MAX_SITD && HcdSITD(HostID,*pTdIdx)->inUse; (*pTdIdx)++)	{}
+	int32_t TdIdx = HcdPoolAlloc(&SItdPool[HostID]);
 
-	if ((*pTdIdx) < HCD_MAX_SITD)
+	if (TdIdx >= 0)
 	{
 		uint8_t TCount = TDLen/SPLIT_MAX_LEN_UFRAME + (TDLen%SPLIT_MAX_LEN_UFRAME ? 1 : 0); /*-- Number of Slipt Transactions --*/
 
+		*pTdIdx = (uint32_t) TdIdx;
 		memset( HcdSITD(HostID,*pTdIdx), 0, sizeof(HCD_SITD) );
 
 		HcdSITD(HostID,*pTdIdx)->inUse = 1;
@@ -876,6 +903,11 @@ static __INLINE PHCD_HS_ITD	HcdHsITD(uint8_t HostID, uint8_t idx)
 	return &(ehci_data[HostID].iTDs[idx]);
 //	return &(ehci_data.iTDs[idx]);
 }
+/* Host owning a descriptor of ehci_data, for the free routines which only get the descriptor */
+static __INLINE uint8_t		HostOfDescriptor(void const* pDescriptor)
+{
+	return ((uint32_t) pDescriptor - (uint32_t) ehci_data) / sizeof(EHCI_HOST_DATA_Type);
+}
 
 static __INLINE Bool		isValidLink(uint32_t link)
 {
@@ -1166,6 +1198,10 @@ static __INLINE HCD_STATUS EHciHostInit(uint8_t HostID)
 
 	/*---------- Host Data Structure Init ----------*/
 //	memset(&ehci_data[HostID], 0, sizeof(EHCI_HOST_DATA_Type) );
+	HcdPoolInit(&QhdPool[HostID], QhdFreeMap[HostID], HCD_MAX_QHD);
+	HcdPoolInit(&QtdPool[HostID], QtdFreeMap[HostID], HCD_MAX_QTD);
+	HcdPoolInit(&HsItdPool[HostID], HsItdFreeMap[HostID], HCD_MAX_HS_ITD);
+	HcdPoolInit(&SItdPool[HostID], SItdFreeMap[HostID], HCD_MAX_SITD);
 
 	/*---------- USBINT ----------*/
 	USB_REG(HostID)->USBINTR_H &= ~EHC_USBINTR_ALL;	/* Disable All Interrupt */
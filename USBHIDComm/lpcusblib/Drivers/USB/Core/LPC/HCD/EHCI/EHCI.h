@@ -40,10 +40,23 @@
 /*=======================================================================*/
 /*  EHCI C O N F I G U R A T I O N                        */
 /*=======================================================================*/
+/* Descriptor pool sizes, may be overridden from the build options */
+#ifndef HCD_MAX_QHD
 #define HCD_MAX_QHD					HCD_MAX_ENDPOINT		/* USBD_USB_HC_EHCI */
+#endif
+#ifndef HCD_MAX_QTD
 #define	HCD_MAX_QTD					(HCD_MAX_ENDPOINT+3)	/* USBD_USB_HC_EHCI */
+#endif
+#ifndef HCD_MAX_HS_ITD
 #define	HCD_MAX_HS_ITD				4						/* USBD_USB_HC_EHCI */
+#endif
+#ifndef HCD_MAX_SITD
 #define HCD_MAX_SITD				16						/* USBD_USB_HC_EHCI */
+#endif
+
+#if HCD_MAX_QHD > 256 || HCD_MAX_QTD > 256 || HCD_MAX_HS_ITD > 256 || HCD_MAX_SITD > 256
+	#error "EHCI descriptor indexes must fit in 8 bits"
+#endif
 
 #define	FRAMELIST_SIZE_BITS			5			/* (0:1024) - (1:512) - (2:256) - (3:128) - (4:64) - (5:32) - (6:16) - (7:8) */
 #define FRAME_LIST_SIZE 			(1024 >> FRAMELIST_SIZE_BITS)
@@ -418,6 +431,7 @@ static __INLINE PHCD_QHD	HcdQHD(uint8_t HostID,uint8_t idx);
 static __INLINE PHCD_QTD	HcdQTD(uint8_t HostID,uint8_t idx);
 static __INLINE PHCD_HS_ITD	HcdHsITD(uint8_t HostID,uint8_t idx);
 static __INLINE PHCD_SITD	HcdSITD(uint8_t HostID,uint8_t idx);
+static __INLINE uint8_t		HostOfDescriptor(void const* pDescriptor);
 static __INLINE Bool		isValidLink(uint32_t link);
 static __INLINE Bool IsInterruptQhd (uint8_t HostID,uint8_t QhdIdx);
 /********************************* Queue Head & Queue TD *********************************/
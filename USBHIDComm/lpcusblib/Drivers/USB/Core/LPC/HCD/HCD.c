@@ -35,6 +35,25 @@
 
 #include "../../USBTask.h"
 
+#if (HCD_COMPLETION_QUEUE_SIZE & (HCD_COMPLETION_QUEUE_SIZE - 1))
+	#error "HCD_COMPLETION_QUEUE_SIZE must be a power of 2"
+#endif
+#if (HCD_COMPLETION_QUEUE_SIZE > 128)
+	#error "HCD_COMPLETION_QUEUE_SIZE must not exceed 128, the 8-bit indexes could not tell a full queue from an empty one"
+#endif
+
+#if HCD_COMPLETION_QUEUE_SIZE
+/* Single producer (host interrupt) / single consumer ring, the indexes free run and are masked on access */
+typedef struct {
+	HCD_COMPLETION Records[HCD_COMPLETION_QUEUE_SIZE];
+	volatile uint8_t Head;		/* Only written by HcdPostCompletion() */
+	volatile uint8_t Tail;		/* Only written by HcdGetCompletion() */
+	uint32_t Dropped;			/* Records lost while the queue was full */
+} HCD_COMPLETION_QUEUE;
+
+static HCD_COMPLETION_QUEUE CompletionQueue[MAX_USB_CORE];
+#endif
+
 /*==========================================================================*/
 /* Private Functions to OHCI EHCI                        											*/
 /*==========================================================================*/
@@ -56,19 +75,155 @@ void assert_status_ok_message(HCD_STATUS status, char const * mess, char const *
 
 void  HcdDelayUS (uint32_t  delay)
 {
-	volatile  uint32_t  i;
+	USB_Timer_DelayUS(delay);	/* Follows SysTick, so it is also accurate inside the USB interrupt */
+}
+void  HcdDelayMS (uint32_t  delay)
+{
+	USB_Timer_DelayMS(delay);
+}
+
+/*********************************************************************//**
+ * @brief		Push a completion record, called from the host interrupt only
+ * @param[in]	HostID			Host Controller Number
+ * @param[in]	PipeHandle		Pipe of the completed transfer
+ * @param[in]	Status			Completion status of the transfer
+ * @param[in]	ActualLength	Bytes transferred
+ * @return 		None
+ * Note: When the queue is full the record is dropped and counted, the pipe status is still
+ *		 updated. Does nothing when HCD_COMPLETION_QUEUE_SIZE is 0
+ **********************************************************************/
+void HcdPostCompletion(uint8_t HostID, uint32_t PipeHandle, HCD_STATUS Status, uint16_t ActualLength)
+{
+#if HCD_COMPLETION_QUEUE_SIZE
+	HCD_COMPLETION_QUEUE* pQueue = &CompletionQueue[HostID];
+	HCD_COMPLETION* pRecord;
 
-	for (i = 0; i < (4 * delay); i++) {    /* This logic was tested. It gives app. 1 micro sec delay        */
-		;
+	if ((uint8_t)(pQueue->Head - pQueue->Tail) >= HCD_COMPLETION_QUEUE_SIZE)
+	{
+		pQueue->Dropped++;
+		return;
 	}
+
+	pRecord = &pQueue->Records[pQueue->Head & (HCD_COMPLETION_QUEUE_SIZE - 1)];
+	pRecord->PipeHandle = PipeHandle;
+	pRecord->Status = Status;
+	pRecord->ActualLength = ActualLength;
+
+	__DMB(); /* Publish the record only once it is filled */
+	pQueue->Head++;
+#else
+	(void) HostID;
+	(void) PipeHandle;
+	(void) Status;
+	(void) ActualLength;
+#endif
 }
-void  HcdDelayMS (uint32_t  delay)
+
+/*********************************************************************//**
+ * @brief		Pop the oldest completion record, without waiting
+ * @param[in]	HostID			Host Controller Number
+ * @param[out]	pCompletion		Completion record
+ * @return 		true if a record was returned, false if no transfer completed since the last call
+ * Note: Lock free against the host interrupt, but there must be a single consumer. An
+ *		 application enabling the queue must drain it, or later completions are dropped
+ **********************************************************************/
+bool HcdGetCompletion(uint8_t HostID, HCD_COMPLETION* const pCompletion)
 {
-	volatile  uint32_t  i;
+#if HCD_COMPLETION_QUEUE_SIZE
+	HCD_COMPLETION_QUEUE* pQueue = &CompletionQueue[HostID];
+
+	if (pQueue->Tail == pQueue->Head)
+		return false;
+
+	*pCompletion = pQueue->Records[pQueue->Tail & (HCD_COMPLETION_QUEUE_SIZE - 1)];
+	__DMB(); /* Release the slot only once it is read */
+	pQueue->Tail++;
+
+	return true;
+#else
+	(void) HostID;
+	(void) pCompletion;
+	return false;
+#endif
+}
 
-	for (i = 0; i < delay; i++) {
-		HcdDelayUS(1000);
+/*********************************************************************//**
+ * @brief		Mark every descriptor of a pool free
+ * @param[in]	pPool			Pool to initialize
+ * @param[in]	pFreeMap		Bitmap of HCD_POOL_WORDS(Size) words
+ * @param[in]	Size			Number of descriptors in the pool
+ * @return 		None
+ **********************************************************************/
+void HcdPoolInit(HCD_POOL* const pPool, uint32_t* const pFreeMap, uint16_t Size)
+{
+	uint32_t Word;
+
+	pPool->FreeMap = pFreeMap;
+	pPool->Size = Size;
+	pPool->FreeCount = Size;
+
+	for (Word = 0; Word < HCD_POOL_WORDS(Size); Word++)
+	{
+		uint32_t Bits = Size - MIN(Size, Word * 32);
+		pFreeMap[Word] = (Bits >= 32) ? 0xFFFFFFFFUL : ((1UL << Bits) - 1);
+	}
+}
+
+/*********************************************************************//**
+ * @brief		Take a free descriptor from a pool
+ * @param[in]	pPool			Pool to allocate from
+ * @return 		Index of the descriptor, or -1 if the pool is exhausted
+ * Note: The bit is found with CLZ, so the cost does not depend on the descriptor
+ *		 position; the pool is shared with the interrupt handler, which frees descriptors
+ **********************************************************************/
+int32_t HcdPoolAlloc(HCD_POOL* const pPool)
+{
+	uint32_t CurrentPriMask = __get_PRIMASK();
+	uint32_t Word;
+	int32_t Idx = -1;
+
+	__disable_irq();
+	for (Word = 0; Word < HCD_POOL_WORDS(pPool->Size); Word++)
+	{
+		uint32_t Map = pPool->FreeMap[Word];
+
+		if (Map)
+		{
+			uint32_t Bit = 31 - __CLZ(Map);
+
+			pPool->FreeMap[Word] = Map & ~(1UL << Bit);
+			pPool->FreeCount--;
+			Idx = (int32_t) (Word * 32 + Bit);
+			break;
+		}
+	}
+	__set_PRIMASK(CurrentPriMask);
+
+	return Idx;
+}
+
+/*********************************************************************//**
+ * @brief		Return a descriptor to its pool
+ * @param[in]	pPool			Pool the descriptor was allocated from
+ * @param[in]	Idx				Index returned by HcdPoolAlloc()
+ * @return 		None
+ * Note: Freeing a descriptor which is already free has no effect
+ **********************************************************************/
+void HcdPoolFree(HCD_POOL* const pPool, uint32_t Idx)
+{
+	uint32_t CurrentPriMask = __get_PRIMASK();
+	uint32_t Mask = 1UL << (Idx % 32);
+
+	if (Idx >= pPool->Size)
+		return;
+
+	__disable_irq();
+	if (!(pPool->FreeMap[Idx / 32] & Mask))
+	{
+		pPool->FreeMap[Idx / 32] |= Mask;
+		pPool->FreeCount++;
 	}
+	__set_PRIMASK(CurrentPriMask);
 }
 
 HCD_STATUS OpenPipe_VerifyParameters( uint8_t HostID, uint8_t DeviceAddr, HCD_USB_SPEED DeviceSpeed, uint8_t EndpointNumber, HCD_TRANSFER_TYPE TransferType, HCD_TRANSFER_DIR TransferDir, uint16_t MaxPacketSize, uint8_t Interval, uint8_t Mult )
@@ -42,11 +42,24 @@
 #define YES									1
 #define NO									0
 
+/* Descriptor pool sizes, may be overridden from the build options */
+#ifndef HCD_MAX_ENDPOINT
 #define HCD_MAX_ENDPOINT					8	/* Maximum number of endpoints */
+#endif
+#ifndef HCD_MAX_TD_PER_ENDPOINT
+#define HCD_MAX_TD_PER_ENDPOINT				4	/* General TDs an endpoint may have in flight, at least 3 for control transfers */
+#endif
+#ifndef HCD_PIPELINED_ENDPOINT
+#define HCD_PIPELINED_ENDPOINT				2	/* Endpoints that can have HCD_MAX_TD_PER_ENDPOINT TDs in flight at the same time */
+#endif
+
+#ifndef HCD_COMPLETION_QUEUE_SIZE
+#define HCD_COMPLETION_QUEUE_SIZE			0	/* Completion records per host, a power of 2; 0 disables the queue, the application must drain it with HcdGetCompletion() */
+#endif
 
 #define HC_RESET_TIMEOUT					10			/* in microseconds */
+#define SOF_WAIT_TIMEOUT_US					2000		/* a running host controller starts a frame every 1 ms */
 #define TRANSFER_TIMEOUT_MS					1000
-#define PORT_RESET_PERIOD_MS				100
 
 /* Control / Bulk transfer is always enabled     */
 #define INTERRUPT_LIST_ENABLE				YES	/* Int transfer enable    */
@@ -120,9 +133,18 @@ typedef enum {
 
 	/* 31-35 */
 	HCD_STATUS_PIPEHANDLE_INVALID,
-	HCD_STATUS_PARAMETER_INVALID
+	HCD_STATUS_PARAMETER_INVALID,
+	HCD_STATUS_NOT_ENOUGH_BANDWIDTH,
+	HCD_STATUS_TIMEOUT
 }HCD_STATUS;
 
+/* Record pushed by the interrupt handler when a transfer completes, see HcdGetCompletion() */
+typedef struct {
+	uint32_t PipeHandle;	/* Pipe the transfer was submitted on */
+	HCD_STATUS Status;		/* HCD_STATUS_OK or the completion code of the failing TD */
+	uint16_t ActualLength;	/* Bytes transferred in the data stage, not counted for isochronous pipes */
+} HCD_COMPLETION;
+
 //////////////////////////////////////////////////////////////////////////
 HCD_STATUS HcdInitDriver (uint8_t HostID);
 HCD_STATUS HcdDeInitDriver(uint8_t HostID);
@@ -156,6 +178,7 @@ HCD_STATUS HcdOpenPipe(uint8_t HostID,
 HCD_STATUS HcdClosePipe(uint32_t PipeHandle);
 HCD_STATUS HcdCancelTransfer(uint32_t PipeHandle);
 HCD_STATUS HcdClearEndpointHalt(uint32_t PipeHandle);
+HCD_STATUS HcdSetPipeInterval(uint32_t PipeHandle, uint8_t Interval);
 
 /************************************************************************/
 /* Transfer API                                                                     */
@@ -163,6 +186,10 @@ HCD_STATUS HcdClearEndpointHalt(uint32_t PipeHandle);
 HCD_STATUS HcdControlTransfer(uint32_t PipeHandle, const USB_Request_Header_t* const pDeviceRequest, uint8_t* const buffer);
 HCD_STATUS HcdDataTransfer(uint32_t PipeHandle, uint8_t* const buffer, uint32_t const length, uint16_t* const pActualTransferred);
 HCD_STATUS HcdGetPipeStatus(uint32_t PipeHandle);
+#if defined(__LPC_OHCI__)
+HCD_STATUS HcdControlTransferSubmit(uint32_t PipeHandle, const USB_Request_Header_t* const pDeviceRequest, uint8_t* const buffer);
+#endif
+bool HcdGetCompletion(uint8_t HostID, HCD_COMPLETION* const pCompletion);
 
 #ifdef LPCUSBlib_DEBUG
 	#define hcd_printf			printf
@@ -184,10 +211,24 @@ HCD_STATUS HcdGetPipeStatus(uint32_t PipeHandle);
 
 #define ASSERT_STATUS_OK(sts)		ASSERT_STATUS_OK_MESSAGE(sts, NULL)
 
+/* Descriptor pool bookkeeping for the OHCI/EHCI drivers: one bit per descriptor, set while the descriptor is free */
+#define HCD_POOL_WORDS(Size)		((Size) ? (((Size) + 31u) / 32u) : 1u)	/* Never 0, so a disabled pool still has a map */
+
+typedef struct {
+	uint32_t* FreeMap;				/* HCD_POOL_WORDS(Size) words */
+	uint16_t Size;
+	volatile uint16_t FreeCount;
+} HCD_POOL;
+
 #if defined(__LPC_OHCI_C__) || defined(__LPC_EHCI_C__)
 
+void  HcdPoolInit(HCD_POOL* const pPool, uint32_t* const pFreeMap, uint16_t Size);
+int32_t HcdPoolAlloc(HCD_POOL* const pPool);
+void  HcdPoolFree(HCD_POOL* const pPool, uint32_t Idx);
+
 void  HcdDelayUS (uint32_t  delay); // TODO use unify delay
 void  HcdDelayMS (uint32_t  delay);
+void  HcdPostCompletion(uint8_t HostID, uint32_t PipeHandle, HCD_STATUS Status, uint16_t ActualLength);
 HCD_STATUS OpenPipe_VerifyParameters( uint8_t HostID, uint8_t DeviceAddr, HCD_USB_SPEED DeviceSpeed, uint8_t EndpointNumber, HCD_TRANSFER_TYPE TransferType, HCD_TRANSFER_DIR TransferDir, uint16_t MaxPacketSize, uint8_t Interval, uint8_t Mult );
 
 static __INLINE uint32_t Align32 (uint32_t Value)
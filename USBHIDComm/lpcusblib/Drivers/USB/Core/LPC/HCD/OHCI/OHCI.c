@@ -40,6 +40,15 @@
 
 OHCI_HOST_DATA_Type ohci_data[MAX_USB_CORE] __DATA(USBRAM_SECTION);
 
+/* 16 ms list (offset from INTERRUPT_16ms_LIST_HEAD) below each 32 ms list, spreads consecutive frames over the tree */
+static const uint8_t InterruptBalance[16] = {0x0, 0x8, 0x4, 0xC, 0x2, 0xA, 0x6, 0xE, 0x1, 0x9, 0x5, 0xD, 0x3, 0xB, 0x7, 0xF};
+
+/* Free descriptors of ohci_data, indexed like HcdED(), HcdGTD() and HcdITD() */
+static HCD_POOL EdPool, GtdPool, ItdPool;
+static uint32_t EdFreeMap[HCD_POOL_WORDS(MAX_ED)];
+static uint32_t GtdFreeMap[HCD_POOL_WORDS(MAX_GTD)];
+static uint32_t ItdFreeMap[HCD_POOL_WORDS(MAX_ITD)];
+
 /*=======================================================================*/
 /*  G L O B A L   S Y M B O L   D E C L A R A T I O N S                  */
 /*=======================================================================*/
@@ -68,14 +77,13 @@ uint32_t HcdGetFrameNumber(uint8_t HostID)
 
 HCD_STATUS HcdRhPortReset(uint8_t HostID, uint8_t uPortNumber)
 {
-	HcdDelayMS(400); // TODO delay should be on Host_LPC
+	/* The guard delays around the reset are non blocking waits of the host state machine, see HOST_PORT_RESET_GUARD_MS */
 	OHCI_REG(HostID)->HcRhPortStatus1 = HC_RH_PORT_STATUS_PortResetStatus; /* SetPortReset */
 	/* should have time-out */
 	while ( OHCI_REG(HostID)->HcRhPortStatus1 & HC_RH_PORT_STATUS_PortResetStatus) {}
 
 	OHCI_REG(HostID)->HcRhPortStatus1 = HC_RH_PORT_STATUS_PortResetStatusChange; /* Clear Port Reset Status Change */
 	
-	HcdDelayMS(400); // TODO delay should be on Host_LPC
 	return HCD_STATUS_OK;
 }
 
@@ -145,6 +153,7 @@ HCD_STATUS HcdOpenPipe(uint8_t HostID,
 {
 	uint32_t EdIdx;
 	uint8_t ListIdx;
+	HCD_STATUS BandwidthStatus = HCD_STATUS_OK;
 
 	(void) Mult; (void) HSHubDevAddr; (void) HSHubPortNum; /* Disable compiler warnings */
 
@@ -179,8 +188,7 @@ HCD_STATUS HcdOpenPipe(uint8_t HostID,
 		break;
 
 		case INTERRUPT_TRANSFER:
-			//ListIdx = FindInterruptTransferListIndex(Interval);
-			ListIdx = INTERRUPT_1ms_LIST_HEAD;
+			ListIdx = FindInterruptTransferListIndex(HostID, Interval);
 		break;
 
 		case ISOCHRONOUS_TRANSFER:
@@ -190,6 +198,16 @@ HCD_STATUS HcdOpenPipe(uint8_t HostID,
 
 	ASSERT_STATUS_OK ( AllocEd(DeviceAddr, DeviceSpeed, EndpointNumber, TransferType, TransferDir, MaxPacketSize, Interval, &EdIdx) ) ;
 
+	if (ListIdx < CONTROL_LIST_HEAD) /* Periodic list */
+	{
+		BandwidthStatus = ReservePeriodicBandwidth(HostID, ListIdx, EndpointBandwidth(EdIdx));
+		if (BandwidthStatus != HCD_STATUS_OK)
+		{
+			FreeED(EdIdx);
+		}
+		ASSERT_STATUS_OK_MESSAGE( BandwidthStatus, "Periodic frame bandwidth exhausted" );
+	}
+
 	/* Add new ED to the EDs List */
 	HcdED(EdIdx)->ListIndex  = ListIdx;
 	InsertEndpoint(HostID, EdIdx, ListIdx);
@@ -209,14 +227,16 @@ HCD_STATUS HcdOpenPipe(uint8_t HostID,
 HCD_STATUS HcdCancelTransfer(uint32_t PipeHandle)
 {
 	uint8_t HostID, EdIdx;
+	uint8_t RemovedTDs = 0;
+	uint32_t CurrentPriMask;
 
 	ASSERT_STATUS_OK ( PipehandleParse(PipeHandle, &HostID, &EdIdx) );
 
 	HcdED(EdIdx)->hcED.Skip = 1;
 
-	/* Clear SOF and wait for the next frame */
-	OHCI_REG(HostID)->HcInterruptStatus = HC_INTERRUPT_StartofFrame;
-	while( !(OHCI_REG(HostID)->HcInterruptStatus & HC_INTERRUPT_StartofFrame) ) /* TODO Should have timeout */
+	/* Wait for the next frame, the HC no longer holds the ED afterwards. Without a frame the HC
+	 * is not running and the TDs can be taken back anyway */
+	WaitForStartOfFrame(HostID);
 
 	/* ISO TD & General TD have the same offset for nextTD, we can use GTD as pointer to travel on TD list */
 	while ( Align16( HcdED(EdIdx)->hcED.HeadP.HeadTD ) != Align16( HcdED(EdIdx)->hcED.TailP ) )
@@ -231,11 +251,20 @@ HCD_STATUS HcdCancelTransfer(uint32_t PipeHandle)
 		{
 			HcdED(EdIdx)->hcED.HeadP.HeadTD = ((PHCD_GeneralTransferDescriptor) HeadTD)->hcGTD.NextTD;
 			FreeGtd((PHCD_GeneralTransferDescriptor) HeadTD);
+			RemovedTDs++;
 		}
 	}
 	HcdED(EdIdx)->hcED.HeadP.HeadTD = Align16( HcdED(EdIdx)->hcED.TailP ); /*-- Toggle Carry/Halted are also set to 0 --*/
 	HcdED(EdIdx)->hcED.HeadP.ToggleCarry = 0;
 
+	/* Retire only the TDs taken off the ED, those already in the done queue are retired by the ISR.
+	 * Masked because the ISR also increments the count */
+	CurrentPriMask = __get_PRIMASK();
+	__disable_irq();
+	HcdED(EdIdx)->RetiredTDs += RemovedTDs;
+	__set_PRIMASK(CurrentPriMask);
+	HcdED(EdIdx)->ActualLength = 0;
+
 	HcdED(EdIdx)->hcED.Skip = 0;
 	return HCD_STATUS_OK;
 }
@@ -277,7 +306,69 @@ HCD_STATUS HcdClearEndpointHalt(uint32_t PipeHandle)
 }
 
 /*********************************************************************//**
- * @brief		Issue Transfer on the control pipe
+ * @brief		Move an interrupt pipe to the polling interval of its endpoint
+ * @param[in]	PipeHandle	Handler of target pipe
+ * @param[in]	Interval	Polling interval in frames (ms), from the endpoint bInterval
+ * @return 		HCD_STATUS
+ *				- HCD_STATUS_OK	: function performs successfully
+ *				- HCD_STATUS_NOT_ENOUGH_BANDWIDTH : no list of that interval has room,
+ *					the pipe keeps its previous interval
+ *				- HCD_STATUS_TIMEOUT : the host controller started no frame, the pipe
+ *					keeps its previous interval
+ *				- Others		: Error occurs
+ * Note: Intervals are rounded down to a power of 2 up to 32 ms. Should be called before
+ *		 any transfer is queued on the pipe; other pipe types only record the interval
+ **********************************************************************/
+HCD_STATUS HcdSetPipeInterval(uint32_t PipeHandle, uint8_t Interval)
+{
+	uint8_t HostID, EdIdx, ListIdx;
+	uint8_t PreviousListIdx;
+	HCD_STATUS MoveStatus;
+
+	ASSERT_STATUS_OK ( PipehandleParse(PipeHandle, &HostID, &EdIdx) );
+
+	if (Interval == 0)
+	{
+		ASSERT_STATUS_OK ( HCD_STATUS_PARAMETER_INVALID );
+	}
+
+	if ( !IsInterruptEndpoint(EdIdx) )
+	{
+		HcdED(EdIdx)->Interval = Interval;
+		return HCD_STATUS_OK;
+	}
+
+	/* Unlink the ED and let a new frame start, so the HC no longer holds it when its NextED changes */
+	HcdED(EdIdx)->hcED.Skip = 1;
+	PreviousListIdx = HcdED(EdIdx)->ListIndex;
+	RemoveEndpoint(HostID, EdIdx);
+
+	MoveStatus = WaitForStartOfFrame(HostID);
+	if (MoveStatus == HCD_STATUS_OK)
+	{
+		ListIdx = FindInterruptTransferListIndex(HostID, Interval);
+		MoveStatus = ReservePeriodicBandwidth(HostID, ListIdx, EndpointBandwidth(EdIdx));
+	}
+	if (MoveStatus == HCD_STATUS_OK)
+	{
+		HcdED(EdIdx)->Interval = Interval;
+	}
+	else
+	{
+		ListIdx = PreviousListIdx;
+		ReservePeriodicBandwidth(HostID, ListIdx, EndpointBandwidth(EdIdx)); /* Just released, cannot fail */
+	}
+
+	HcdED(EdIdx)->ListIndex = ListIdx;
+	InsertEndpoint(HostID, EdIdx, ListIdx);
+	HcdED(EdIdx)->hcED.Skip = 0;
+
+	ASSERT_STATUS_OK_MESSAGE( MoveStatus, "Interrupt pipe keeps its previous interval" );
+	return HCD_STATUS_OK;
+}
+
+/*********************************************************************//**
+ * @brief		Issue Transfer on the control pipe and wait for it to complete
  * @param[in]	PipeHandle		Handler of target pipe
  * @param[in]	pDeviceRequest	8-byte device request
  * @param[in]	buffer
@@ -292,6 +383,31 @@ HCD_STATUS HcdControlTransfer(uint32_t PipeHandle, const USB_Request_Header_t* c
 {
 	uint8_t HostID, EdIdx;
 
+	ASSERT_STATUS_OK ( HcdControlTransferSubmit(PipeHandle, pDeviceRequest, buffer) );
+	PipehandleParse(PipeHandle, &HostID, &EdIdx);
+
+	/* wait for semaphore compete TDs */
+	ASSERT_STATUS_OK ( WaitForTransferComplete(EdIdx) );
+
+	return HCD_STATUS_OK;
+}
+
+/*********************************************************************//**
+ * @brief		Queue a transfer on the control pipe and return, completion is
+ *				reported by HcdGetPipeStatus(), and by HcdGetCompletion() when the
+ *				completion queue is enabled
+ * @param[in]	PipeHandle		Handler of target pipe
+ * @param[in]	pDeviceRequest	8-byte device request, must stay valid until completion
+ * @param[in]	buffer			Data stage buffer, must stay valid until completion
+ * @return 		HCD_STATUS
+ *				- HCD_STATUS_OK	: transfer is queued
+ *				- Others		: Error occurs
+ * Note: 
+ **********************************************************************/
+HCD_STATUS HcdControlTransferSubmit(uint32_t PipeHandle, const USB_Request_Header_t* const pDeviceRequest, uint8_t* const buffer)
+{
+	uint8_t HostID, EdIdx;
+
 	if (pDeviceRequest == NULL || buffer == NULL)
 	{
 		ASSERT_STATUS_OK_MESSAGE(HCD_STATUS_PARAMETER_INVALID, "Device Request or Data Buffer is NULL");
@@ -299,6 +415,12 @@ HCD_STATUS HcdControlTransfer(uint32_t PipeHandle, const USB_Request_Header_t* c
 
 	ASSERT_STATUS_OK ( PipehandleParse(PipeHandle, &HostID, &EdIdx) );
 
+	/* Setup, optional data and status TDs */
+	ASSERT_STATUS_OK ( ReserveGTDs(EdIdx, pDeviceRequest->wLength ? 3 : 2) );
+
+	/* Before the first TD is linked, the controller may retire them as soon as they are queued */
+	HcdED(EdIdx)->status = HCD_STATUS_TRANSFER_QUEUED;
+
 	/************************************************************************/
 	/* Setup Stage                                                          */
 	/************************************************************************/
@@ -319,20 +441,16 @@ HCD_STATUS HcdControlTransfer(uint32_t PipeHandle, const USB_Request_Header_t* c
 	/* set control list filled */
 	OHCI_REG(HostID)->HcCommandStatus |= HC_COMMAND_STATUS_ControlListFilled;
 
-	HcdED(EdIdx)->status = HCD_STATUS_TRANSFER_QUEUED;
-
-	/* wait for semaphore compete TDs */
-	ASSERT_STATUS_OK ( WaitForTransferComplete(EdIdx) );
-
 	return HCD_STATUS_OK;
 }
 
-static HCD_STATUS QueueOneITD(uint32_t EdIdx, uint8_t* dataBuff, uint32_t TDLen, uint16_t StartingFrame)
+static HCD_STATUS QueueOneITD(uint32_t EdIdx, uint8_t* dataBuff, uint32_t TDLen, uint16_t StartingFrame, uint8_t IOC)
 {
 	uint32_t i;
 	PHCD_IsoTransferDescriptor pItd = (PHCD_IsoTransferDescriptor) Align16( HcdED(EdIdx)->hcED.TailP );
 	
 	pItd->StartingFrame = StartingFrame;
+	pItd->DelayInterrupt = IOC ? 0 : TD_NoInterruptOnComplete; /* Only the last ITD of a request interrupts */
 	pItd->FrameCount = (TDLen / HcdED(EdIdx)->hcED.MaxPackageSize) + (TDLen % HcdED(EdIdx)->hcED.MaxPackageSize ? 1 : 0) - 1;
 	pItd->BufferPage0 = Align4k( (uint32_t) dataBuff );
 	pItd->BufferEnd = (uint32_t) (dataBuff + TDLen - 1);
@@ -388,7 +506,7 @@ static HCD_STATUS QueueITDs(uint32_t EdIdx, uint8_t* dataBuff, uint32_t xferLen)
 		xferLen -= TdLen;
 
 		/*---------- Fill data to Place hodler TD ----------*/
-		ASSERT_STATUS_OK ( QueueOneITD(EdIdx, dataBuff, TdLen, FrameIdx) );
+		ASSERT_STATUS_OK ( QueueOneITD(EdIdx, dataBuff, TdLen, FrameIdx, (xferLen ? 0 : 1)) );
 		
 		FrameIdx = (FrameIdx + FramePeriod) % (1<<16);
 		dataBuff += TdLen;
@@ -411,6 +529,16 @@ HCD_STATUS HcdDataTransfer( uint32_t PipeHandle, uint8_t* const buffer, uint32_t
 
 	ExpectedLength = (length != HCD_ENDPOINT_MAXPACKET_XFER_LEN) ? length : HcdED(EdIdx)->hcED.MaxPackageSize; /* LUFA adaption, receive only 1 data transaction */
 
+	if ( !IsIsoEndpoint(EdIdx) )
+	{
+		/* Refuse up front rather than leaving a partly queued request on the ED */
+		ASSERT_STATUS_OK( ReserveGTDs(EdIdx, CountGTDs(buffer, ExpectedLength)) );
+	}
+
+	/* With requests already in flight, the pipe status and actual length refer to the last one submitted */
+	HcdED(EdIdx)->status = HCD_STATUS_TRANSFER_QUEUED;
+	HcdED(EdIdx)->pActualTransferCount = pActualTransferred ; /* TODO refractor Actual length transfer */
+
 	if ( IsIsoEndpoint(EdIdx) ) /* Iso Transfer */
 	{
 		ASSERT_STATUS_OK( QueueITDs(EdIdx, buffer, ExpectedLength) );
@@ -423,9 +551,6 @@ HCD_STATUS HcdDataTransfer( uint32_t PipeHandle, uint8_t* const buffer, uint32_t
 		}
 	}
 
-	HcdED(EdIdx)->status = HCD_STATUS_TRANSFER_QUEUED;
-	HcdED(EdIdx)->pActualTransferCount = pActualTransferred ; /* TODO refractor Actual length transfer */
-
 	return HCD_STATUS_OK;
 }
 
@@ -492,6 +617,9 @@ static void ProcessDoneQueue(uint8_t HostID, uint32_t donehead)
 	while(pTDList != NULL)
 	{
 		uint32_t EdIdx;
+		bool Completed = false;
+		bool Idle = true;
+		HCD_STATUS RequestStatus;
 
 		pCurTD	= pTDList;
 		pTDList = (PHC_GTD) pTDList->NextTD;
@@ -511,23 +639,35 @@ static void ProcessDoneQueue(uint8_t HostID, uint32_t donehead)
 				pGtd->TransferCount -= ( Align4k( ((uint32_t)pGtd->hcGTD.BufferEnd) ^ ((uint32_t)pGtd->hcGTD.CurrentBufferPointer) ) ? 0x00001000 : 0 ) +
 										Offset4k((uint32_t)pGtd->hcGTD.BufferEnd) - Offset4k((uint32_t)pGtd->hcGTD.CurrentBufferPointer) + 1;
 			}
+			if (pGtd->hcGTD.DirectionPID != 0) /* SETUP bytes are not part of the request data */
+				HcdED(EdIdx)->ActualLength += pGtd->TransferCount;
 			if (HcdED(EdIdx)->pActualTransferCount)
-				*(HcdED(EdIdx)->pActualTransferCount) = pGtd->TransferCount; /* increase usb request transfer count */
-			
+				*(HcdED(EdIdx)->pActualTransferCount) = HcdED(EdIdx)->ActualLength; /* increase usb request transfer count */
+
+			HcdED(EdIdx)->RetiredTDs++;
+			Idle = (HcdED(EdIdx)->RetiredTDs == HcdED(EdIdx)->QueuedTDs); /* later requests may still be queued */
 		}
 
+		RequestStatus = (HCD_STATUS) pCurTD->ConditionCode;
+
 		if (pCurTD->DelayInterrupt != TD_NoInterruptOnComplete) /* Update ED status if Interrupt on Complete is set */
 		{
-			HcdED(EdIdx)->status = pCurTD->ConditionCode;
+			if (Idle)
+			{
+				HcdED(EdIdx)->status = RequestStatus;
+			}
+			Completed = true;
 		}
 
 		if ( pCurTD->ConditionCode ) /* also update ED status if TD complete with error */
 		{
-			HcdED(EdIdx)->status = (HcdED(EdIdx)->hcED.HeadP.Halted == 1) ? HCD_STATUS_TRANSFER_Stall : pCurTD->ConditionCode;
+			RequestStatus = (HcdED(EdIdx)->hcED.HeadP.Halted == 1) ? HCD_STATUS_TRANSFER_Stall : (HCD_STATUS) pCurTD->ConditionCode;
+			HcdED(EdIdx)->status = RequestStatus;
 			HcdED(EdIdx)->hcED.HeadP.Halted = 0;
 			hcd_printf("Error on Endpoint 0x%X has HCD_STATUS code %d\r\n",
 					HcdED(EdIdx)->hcED.FunctionAddr | (HcdED(EdIdx)->hcED.Direction == 2 ? 0x80 : 0x00),
 					pCurTD->ConditionCode);
+			Completed = true;
 		}
 
 		/* remove completed TD from usb request list, if request list is now empty complete usb request */
@@ -539,7 +679,15 @@ static void ProcessDoneQueue(uint8_t HostID, uint32_t donehead)
 			FreeGtd( (PHCD_GeneralTransferDescriptor) pCurTD );
 		}
 
-		/* Post Semaphore to signal TDs are transfer */
+		/* Signal the request completion to whoever waits on it */
+		if (Completed)
+		{
+			uint32_t PipeHandle;
+
+			PipehandleCreate(&PipeHandle, HostID, EdIdx);
+			HcdPostCompletion(HostID, PipeHandle, RequestStatus, HcdED(EdIdx)->ActualLength);
+			HcdED(EdIdx)->ActualLength = 0; /* next request on this ED starts counting */
+		}
 	}
 }
 #if SCHEDULING_OVRERRUN_INTERRUPT
@@ -702,11 +850,16 @@ static HCD_STATUS QueueOneGTD (uint32_t EdIdx, uint8_t* const CurrentBufferPoint
 	TailP->TransferCount = xferLen;
 	if (!IOC)
 	{
-		TailP->hcGTD.DelayInterrupt = TD_NoInterruptOnComplete; /* Delay Interrupt with  */
+		TailP->hcGTD.DelayInterrupt = TD_NoInterruptOnComplete; /* Retired silently, reported with the last TD of the request */
+	}
+	else if (IsInterruptEndpoint(EdIdx))
+	{
+		TailP->hcGTD.DelayInterrupt = INTERRUPT_COALESCING_FRAMES; /* Share the done queue interrupt with other interrupt pipes */
 	}
 
 	/* Create a new place holder TD & link setup TD to the new place holder */
 	ASSERT_STATUS_OK ( AllocGtdForEd(EdIdx) );
+	HcdED(EdIdx)->QueuedTDs++;
 
 	return HCD_STATUS_OK;
 }
@@ -727,10 +880,48 @@ static HCD_STATUS QueueGTDs (uint32_t EdIdx, uint8_t* dataBuff, uint32_t xferLen
 	return HCD_STATUS_OK;
 }
 
+/* Number of general TDs QueueGTDs() splits a transfer into */
+static uint32_t CountGTDs (uint8_t* dataBuff, uint32_t xferLen)
+{
+	uint32_t TdCount = 0;
+
+	while (xferLen > 0)
+	{
+		uint32_t TdLen = MIN(xferLen, TD_MAX_XFER_LENGTH - Offset4k((uint32_t)dataBuff));
+
+		xferLen -= TdLen;
+		dataBuff += TdLen;
+		TdCount++;
+	}
+	return TdCount;
+}
+
+/* Check that TdCount more general TDs fit in the ED queue depth and in the pool */
+static HCD_STATUS ReserveGTDs (uint32_t EdIdx, uint32_t TdCount)
+{
+	uint8_t InFlight = HcdED(EdIdx)->QueuedTDs - HcdED(EdIdx)->RetiredTDs;
+
+	if (InFlight + TdCount > HCD_MAX_TD_PER_ENDPOINT)
+		return HCD_STATUS_NOT_ENOUGH_GTD;
+
+	/* The ISR only frees GTDs, so the count cannot drop before they are allocated */
+	return (GtdPool.FreeCount >= TdCount) ? HCD_STATUS_OK : HCD_STATUS_NOT_ENOUGH_GTD;
+}
+
 static HCD_STATUS WaitForTransferComplete( uint8_t EdIdx ) 
 {
 #ifndef __TEST__
+	/* Sleep until the done queue interrupt updates the status; WFI still wakes up on an
+	 * interrupt that became pending while masked, so a completion cannot be missed */
 	while ( HcdED(EdIdx)->status == HCD_STATUS_TRANSFER_QUEUED ){
+		uint32_t CurrentPriMask = __get_PRIMASK();
+
+		__disable_irq();
+		if ( HcdED(EdIdx)->status == HCD_STATUS_TRANSFER_QUEUED )
+		{
+			__WFI();
+		}
+		__set_PRIMASK(CurrentPriMask);
 	}
 	return (HCD_STATUS) HcdED(EdIdx)->status ;
 #else
@@ -746,11 +937,6 @@ static __INLINE HCD_STATUS InsertEndpoint( uint8_t HostID, uint32_t EdIdx, uint8
 	HcdED(EdIdx)->hcED.NextED = list_head->NextED;	
 	list_head->NextED = (uint32_t) HcdED(EdIdx);
 
-// 	if ( IsInterruptEndpoint(EdIdx) )
-// 	{
-// 		OHCI_HOST_DATA->staticEDs[ListIndex].TailP += HcdED(EdIdx)->hcED.MaxPackageSize;	/* increase the bandwidth for the found list */
-// 	}
-
 	return HCD_STATUS_OK;
 }
 
@@ -765,86 +951,181 @@ static __INLINE HCD_STATUS RemoveEndpoint( uint8_t HostID, uint32_t EdIdx )
 		prevED = (PHCD_EndpointDescriptor) (prevED->hcED.NextED) ;
 	}
 
-// 	if ( IsInterruptEndpoint(EdIdx) )
-// 	{
-// 		OHCI_HOST_DATA->staticEDs[HcdED(EdIdx)->ListIndex].TailP -= HcdED(EdIdx)->hcED.MaxPackageSize;	/* decrease the bandwidth for the removed list */
-// 	}
+	if ( HcdED(EdIdx)->ListIndex < CONTROL_LIST_HEAD ) /* Periodic list */
+	{
+		ReleasePeriodicBandwidth(HostID, HcdED(EdIdx)->ListIndex, EndpointBandwidth(EdIdx));
+	}
 	prevED->hcED.NextED = HcdED(EdIdx)->hcED.NextED;
 
 	return HCD_STATUS_OK;
 }
 
-#if 0	/* We dont need to manage bandwidth this hard */
-
-__INLINE uint8_t FindInterruptTransferListIndex( uint8_t HostID, uint8_t Interval )
+/* Interrupt list of the given interval with the least loaded frames, the interval is rounded down to a power of 2 (1 to 32 ms) */
+static uint8_t FindInterruptTransferListIndex( uint8_t HostID, uint8_t Interval )
 {
-	uint8_t ListLeastBandwidth;
-	uint8_t ListEnd;
-	uint8_t ListIdx = INTERRUPT_32ms_LIST_HEAD;
+#if INTERRUPT_LIST_ENABLE
+	uint8_t Period = 32;
+	uint8_t ListIdx, ListLeastBandwidth;
 
-	/* Find the correct interval list with right power of 2, i.e: 1,2,4,8,16,32 ms */
-	while ( (ListIdx >= Interval) && (ListIdx >>= 1) ) {}
-	ListEnd = ListIdx << 1;
+	while (Period > Interval)
+	{
+		Period >>= 1;
+	}
 
-	/* Find the least bandwidth in the same interval */
-	/* Note: For Interrupt Static ED (0 to 62), TailP is used to store the accumulated bandwidth of the list */
-	for (ListLeastBandwidth=ListIdx; ListIdx <= ListEnd; ListIdx++ )
+	/* The lists of a period are Period-1 .. 2*Period-2, see BuildPeriodicStaticEdTree */
+	for (ListLeastBandwidth = ListIdx = Period - 1; ListIdx < 2 * Period - 1; ListIdx++)
 	{
-		if ( ohci_data[HostID].staticEDs[ListIdx].TailP < ohci_data[HostID].staticEDs[ListLeastBandwidth].TailP )
+		if ( ListPeakBandwidth(HostID, ListIdx) < ListPeakBandwidth(HostID, ListLeastBandwidth) )
 		{
 			ListLeastBandwidth = ListIdx;
 		}
 	}
 	return ListLeastBandwidth;
+#else
+	/* No interrupt tree, only the head shared with the ISO list, polled every frame */
+	(void) HostID;
+	(void) Interval;
+	return INTERRUPT_1ms_LIST_HEAD;
+#endif
+}
+
+/* Whether the HC goes through list ListIdx in the frames where (frame number % 32) == Frame */
+static bool IsListInFrame( uint8_t ListIdx, uint8_t Frame )
+{
+#if INTERRUPT_LIST_ENABLE
+	uint8_t Node;
+
+	if (ListIdx == ISO_LIST_HEAD || ListIdx == INTERRUPT_32ms_LIST_HEAD + Frame)
+	{
+		return true;
+	}
+
+	/* Follow the path the HC takes from the 16 ms list down to the 1 ms list */
+	for (Node = INTERRUPT_16ms_LIST_HEAD + InterruptBalance[Frame & 0xF]; Node != ListIdx; Node = (Node - 1) / 2)
+	{
+		if (Node == INTERRUPT_1ms_LIST_HEAD)
+		{
+			return false;
+		}
+	}
+	return true;
+#else
+	/* Without the tree the only periodic list is the ISO head, which is in every frame */
+	(void) ListIdx;
+	(void) Frame;
+	return true;
+#endif
+}
+
+/* Full speed bit times of one transaction of the ED, with worst case bit stuffing */
+static uint16_t EndpointBandwidth( uint8_t EdIdx )
+{
+	uint32_t Bytes = HcdED(EdIdx)->hcED.MaxPackageSize + (IsIsoEndpoint(EdIdx) ? ISO_PROTOCOL_OVERHEAD : INTERRUPT_PROTOCOL_OVERHEAD);
+	uint32_t BitTimes = (Bytes * 8 * 7) / 6;
+
+	return HcdED(EdIdx)->hcED.Speed ? (BitTimes * 8) : BitTimes; /* a low speed bit lasts 8 full speed bits */
+}
+
+/* Largest periodic load among the frames going through the list */
+static uint16_t ListPeakBandwidth( uint8_t HostID, uint8_t ListIdx )
+{
+	uint8_t Frame;
+	uint16_t Peak = 0;
+
+	for (Frame = 0; Frame < 32; Frame++)
+	{
+		if ( IsListInFrame(ListIdx, Frame) )
+		{
+			Peak = MAX(Peak, ohci_data[HostID].PeriodicBandwidth[Frame]);
+		}
+	}
+	return Peak;
+}
+
+/* Account an ED on a periodic list, refused if one of its frames would go over PERIODIC_BANDWIDTH_MAX */
+static HCD_STATUS ReservePeriodicBandwidth( uint8_t HostID, uint8_t ListIdx, uint16_t Bandwidth )
+{
+	uint8_t Frame;
+
+	if (ListPeakBandwidth(HostID, ListIdx) + Bandwidth > PERIODIC_BANDWIDTH_MAX)
+	{
+		return HCD_STATUS_NOT_ENOUGH_BANDWIDTH;
+	}
+
+	for (Frame = 0; Frame < 32; Frame++)
+	{
+		if ( IsListInFrame(ListIdx, Frame) )
+		{
+			ohci_data[HostID].PeriodicBandwidth[Frame] += Bandwidth;
+		}
+	}
+	return HCD_STATUS_OK;
+}
+
+/* Waits for the next SOF, bounded so a halted or suspended host controller cannot hang the caller */
+static HCD_STATUS WaitForStartOfFrame( uint8_t HostID )
+{
+	uint32_t Waited;
+
+	OHCI_REG(HostID)->HcInterruptStatus = HC_INTERRUPT_StartofFrame;
+	for (Waited = 0; !(OHCI_REG(HostID)->HcInterruptStatus & HC_INTERRUPT_StartofFrame); Waited += 10)
+	{
+		if (Waited >= SOF_WAIT_TIMEOUT_US)
+		{
+			return HCD_STATUS_TIMEOUT;
+		}
+		HcdDelayUS(10);
+	}
+	return HCD_STATUS_OK;
+}
+
+static void ReleasePeriodicBandwidth( uint8_t HostID, uint8_t ListIdx, uint16_t Bandwidth )
+{
+	uint8_t Frame;
+
+	for (Frame = 0; Frame < 32; Frame++)
+	{
+		if ( IsListInFrame(ListIdx, Frame) )
+		{
+			ohci_data[HostID].PeriodicBandwidth[Frame] -= Bandwidth;
+		}
+	}
 }
 
 /* build static EDs tree for periodic transfer */
 static __INLINE void BuildPeriodicStaticEdTree( uint8_t HostID )
 {
+	uint32_t idx;
 #if INTERRUPT_LIST_ENABLE
 	/* Build full binary tree for interrupt list */
-	uint32_t idx, count;
-	uint32_t Balance[16] = {0x0, 0x8, 0x4, 0xC, 0x2, 0xA, 0x6, 0xE, 0x1, 0x9, 0x5, 0xD, 0x3, 0xB, 0x7, 0xF};
+	uint32_t count;
 
 	/* build static tree for 1 -> 16 ms */
-	OHCI_HOST_DATA->staticEDs[0].NextED = 0;
 	for (idx=1; idx < INTERRUPT_32ms_LIST_HEAD; idx++)
 	{
-		OHCI_HOST_DATA->staticEDs[idx].NextED = (uint32_t) &(OHCI_HOST_DATA->staticEDs[(idx-1)/2]);
+		ohci_data[HostID].staticEDs[idx].NextED = (uint32_t) &(ohci_data[HostID].staticEDs[(idx-1)/2]);
 	}
 	/* create 32ms EDs which will be assigned to HccaInterruptTable */
 	for (count=0, idx=INTERRUPT_32ms_LIST_HEAD; count < 32; count++, idx++)
 	{
-		OHCI_HOST_DATA->staticEDs[idx].NextED = (uint32_t) &(OHCI_HOST_DATA->staticEDs[ Balance[count & 0xF] + INTERRUPT_16ms_LIST_HEAD ]);
+		ohci_data[HostID].staticEDs[idx].NextED = (uint32_t) &(ohci_data[HostID].staticEDs[ InterruptBalance[count & 0xF] + INTERRUPT_16ms_LIST_HEAD ]);
 	}
 	/* Hook to HCCA interrupt Table */
 	for (idx = 0; idx < 32; idx++)
 	{
-		OHCI_HOST_DATA->hcca.HccaIntTable[idx] = (uint32_t) &(OHCI_HOST_DATA->staticEDs[idx+INTERRUPT_32ms_LIST_HEAD]) ;
-	}
-	OHCI_HOST_DATA->staticEDs[INTERRUPT_1ms_LIST_HEAD].NextED = (uint32_t) &(OHCI_HOST_DATA->staticEDs[ISO_LIST_HEAD]);
-#elif ISO_LIST_ENABLE
-	for (idx = 0; idx < 32; idx++)
-	{
-		OHCI_HOST_DATA->hcca.HccaIntTable[idx] = (uint32_t) &(OHCI_HOST_DATA->staticEDs[ISO_LIST_HEAD]) ;
+		ohci_data[HostID].hcca.HccaIntTable[idx] = (uint32_t) &(ohci_data[HostID].staticEDs[idx+INTERRUPT_32ms_LIST_HEAD]) ;
 	}
-#endif
-}
-
+	/* ISO EDs come last in every frame */
+	ohci_data[HostID].staticEDs[INTERRUPT_1ms_LIST_HEAD].NextED = (uint32_t) &(ohci_data[HostID].staticEDs[ISO_LIST_HEAD]);
+	ohci_data[HostID].staticEDs[ISO_LIST_HEAD].NextED = 0;
 #else
-
-static __INLINE void BuildPeriodicStaticEdTree( uint8_t HostID )
-{
-	/* Treat all interrupt interval as 1ms (maximum rate) */
-	uint32_t idx;
 	for (idx = 0; idx < 32; idx++)
 	{
-		ohci_data[HostID].hcca.HccaIntTable[idx] = (uint32_t) &(ohci_data[HostID].staticEDs[INTERRUPT_1ms_LIST_HEAD]) ;
+		ohci_data[HostID].hcca.HccaIntTable[idx] = (uint32_t) &(ohci_data[HostID].staticEDs[ISO_LIST_HEAD]) ;
 	}
 	/* ISO_LIST_HEAD is an alias for INTERRUPT_1ms_LIST_HEAD */
-}
-
 #endif
+}
 
 static __INLINE uint32_t Align16 (uint32_t Value)
 {
@@ -897,10 +1178,12 @@ static HCD_STATUS PipehandleParse(uint32_t Pipehandle, uint8_t* HostID, uint8_t*
 
 static __INLINE HCD_STATUS AllocEd( uint8_t DeviceAddr, HCD_USB_SPEED DeviceSpeed, uint8_t EndpointNumber, HCD_TRANSFER_TYPE TransferType, HCD_TRANSFER_DIR TransferDir, uint16_t MaxPacketSize, uint8_t Interval, uint32_t* pEdIdx )
 {
-	/* Looking for free EDs */
-	for ((*pEdIdx) = 0; ((*pEdIdx) < MAX_ED) && HcdED((*pEdIdx))->inUse; (*pEdIdx)++) {	}
-	if ((*pEdIdx) >= MAX_ED)
+	HCD_STATUS PlaceHolderStatus;
+	int32_t EdIdx = HcdPoolAlloc(&EdPool);
+
+	if (EdIdx < 0)
 		return HCD_STATUS_NOT_ENOUGH_ENDPOINT;
+	*pEdIdx = (uint32_t) EdIdx;
 
 	/* Init Data for new ED */
 	memset( HcdED(*pEdIdx), 0, sizeof(HCD_EndpointDescriptor) );
@@ -917,26 +1200,24 @@ static __INLINE HCD_STATUS AllocEd( uint8_t DeviceAddr, HCD_USB_SPEED DeviceSpee
 	HcdED((*pEdIdx))->Interval = Interval;
 	
 	/* Allocate Place Holder TD as suggested by OHCI 5.2.8 */
-	if (TransferType != ISOCHRONOUS_TRANSFER)
+	PlaceHolderStatus = (TransferType != ISOCHRONOUS_TRANSFER) ? AllocGtdForEd(*pEdIdx) : AllocItdForEd(*pEdIdx);
+	if (PlaceHolderStatus != HCD_STATUS_OK)
 	{
-		ASSERT_STATUS_OK ( AllocGtdForEd(*pEdIdx) );
-	}
-	else
-	{
-		ASSERT_STATUS_OK ( AllocItdForEd(*pEdIdx) );
+		/* No place holder, give the ED back rather than leaking it */
+		HcdED(*pEdIdx)->inUse = 0;
+		HcdPoolFree(&EdPool, *pEdIdx);
 	}
+	ASSERT_STATUS_OK ( PlaceHolderStatus );
 
 	return HCD_STATUS_OK;
 }
 
 static HCD_STATUS AllocGtdForEd(uint8_t EdIdx)
 {
-	uint32_t GtdIdx;
-
 	/* Allocate new GTD */
-	for (GtdIdx = 0; (GtdIdx < MAX_GTD) && HcdGTD(GtdIdx)->inUse; GtdIdx++) {}
+	int32_t GtdIdx = HcdPoolAlloc(&GtdPool);
 
-	if (GtdIdx < MAX_GTD)
+	if (GtdIdx >= 0)
 	{
 		/***************    Control (word 0) ****************/
 		/* Buffer rounding:    R = 1b (yes)                 */
@@ -974,11 +1255,9 @@ static HCD_STATUS AllocGtdForEd(uint8_t EdIdx)
 }
 static HCD_STATUS AllocItdForEd(uint8_t EdIdx)
 {
-	uint32_t ItdIdx;
+	int32_t ItdIdx = HcdPoolAlloc(&ItdPool);
 
-	for (ItdIdx = 0; (ItdIdx < MAX_ITD) && HcdITD(ItdIdx)->inUse; ItdIdx++) {}
-	
-	if (ItdIdx < MAX_ITD)
+	if (ItdIdx >= 0)
 	{
 		memset( HcdITD(ItdIdx), 0, sizeof(HCD_IsoTransferDescriptor) );
 		HcdITD(ItdIdx)->inUse = 1;
@@ -1016,6 +1295,7 @@ static __INLINE HCD_STATUS FreeED( uint8_t EdIdx )
 
 	HcdED(EdIdx)->status = HCD_STATUS_TRANSFER_NotAccessed;
 	HcdED(EdIdx)->inUse = 0;
+	HcdPoolFree(&EdPool, EdIdx);
 
 	return HCD_STATUS_OK;
 }
@@ -1023,12 +1303,14 @@ static __INLINE HCD_STATUS FreeED( uint8_t EdIdx )
 static __INLINE HCD_STATUS FreeGtd(PHCD_GeneralTransferDescriptor pGtd)
 {
 	pGtd->inUse = 0;
+	HcdPoolFree(&GtdPool, pGtd - HcdGTD(0));
 	return HCD_STATUS_OK;
 }
 
 static __INLINE HCD_STATUS FreeItd(PHCD_IsoTransferDescriptor pItd)
 {
 	pItd->inUse = 0;
+	HcdPoolFree(&ItdPool, pItd - HcdITD(0));
 	return HCD_STATUS_OK;
 }
 
@@ -1047,6 +1329,10 @@ static __INLINE HCD_STATUS OHciHostInit(uint8_t HostID)
 	memset(&ohci_data[HostID], 0, sizeof(OHCI_HOST_DATA_Type));
 	/* Skip writing 1s to HcHCCA, assume it is 256 aligned */
 
+	HcdPoolInit(&EdPool, EdFreeMap, MAX_ED);
+	HcdPoolInit(&GtdPool, GtdFreeMap, MAX_GTD);
+	HcdPoolInit(&ItdPool, ItdFreeMap, MAX_ITD);
+
 	/* set skip bit for all static EDs */
 	for (idx=0; idx < MAX_STATIC_ED; idx++)
 	{
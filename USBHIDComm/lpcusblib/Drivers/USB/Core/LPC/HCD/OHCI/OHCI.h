@@ -40,13 +40,32 @@
 /*=======================================================================*/
 /*  OHCI C O N F I G U R A T I O N                        */
 /*=======================================================================*/
+#ifndef MAX_ED
 #define MAX_ED								HCD_MAX_ENDPOINT
-#define MAX_GTD								(MAX_ED + 3)
-#define MAX_STATIC_ED						3 /* Serve as list head, fixed, not configurable */
+#endif
+#ifndef MAX_GTD
+#define MAX_GTD								(MAX_ED + (HCD_MAX_TD_PER_ENDPOINT * HCD_PIPELINED_ENDPOINT)) /* One place holder per ED + queued TDs */
+#endif
+#if INTERRUPT_LIST_ENABLE
+	#define MAX_STATIC_ED					(63 + 3) /* Interrupt tree (32 + 16 + ... + 1 ms lists) + ISO, control and bulk heads, fixed */
+#else
+	#define MAX_STATIC_ED					3 /* Serve as list head, fixed, not configurable */
+#endif
+
+#if HCD_MAX_TD_PER_ENDPOINT < 3
+	#error "HCD_MAX_TD_PER_ENDPOINT must allow the 3 stages of a control transfer"
+#endif
+
+#if MAX_ED > 255 || MAX_GTD > 256
+	#error "ED and GTD indexes must fit in 8 bits"
+#endif
 
 #if ISO_LIST_ENABLE
+	#ifndef MAX_ITD
 	#define MAX_ITD								4
+	#endif
 #else
+	#undef MAX_ITD
 	#define MAX_ITD								0
 #endif
 
@@ -73,6 +92,20 @@
 /* RH_STATUS_CHANGE_INT Must be YES */
 #define OWNERSHIP_CHANGE_INTERRUPT			NO
 
+/*************************************/
+/* General TD DelayInterrupt (Done Queue) */
+/*************************************/
+/* Frames (0 to 6) the done queue interrupt may be held back after an interrupt pipe transfer
+ * completes, so that completions of several slow pipes are handled by one interrupt.
+ * The pipe status is only updated by that interrupt, 0 signals every transfer right away */
+#ifndef INTERRUPT_COALESCING_FRAMES
+#define INTERRUPT_COALESCING_FRAMES			0
+#endif
+
+#if INTERRUPT_COALESCING_FRAMES > 6
+	#error "INTERRUPT_COALESCING_FRAMES must be below 7, which disables the interrupt"
+#endif
+
 /*************************/
 /* HcFmInterval Register */
 /*************************/
@@ -84,6 +117,13 @@
 /*******************/
 #define PERIODIC_START						0x00002A27UL		/* 10% off from FRAME_INTERVAL */
 
+/**********************/
+/* Periodic Bandwidth */
+/**********************/
+#define PERIODIC_BANDWIDTH_MAX				((FRAME_INTERVAL * 9) / 10)	/* Full speed bit times per frame, 90% as in USB 2.0 5.6.4 / 5.7.4 */
+#define INTERRUPT_PROTOCOL_OVERHEAD			13			/* Bytes per interrupt transaction besides data, USB 2.0 5.7.3 */
+#define ISO_PROTOCOL_OVERHEAD				9			/* Bytes per isochronous transaction besides data, USB 2.0 5.6.3 */
+
 /*******************/
 /* HcRhDescriptorA Register (Currently has no effects) */
 /*******************/
@@ -239,7 +279,9 @@ typedef struct st_HCD_EndpointDescriptor {	// 32 byte align
 	__IO uint32_t status; 			// TODO status is updated by ISR --> is non-caching
 	uint16_t *pActualTransferCount; /* total transferred bytes of a usb request */
 
-	uint32_t reserved;
+	uint16_t ActualLength;			/* bytes transferred by the retired TDs of the current request */
+	uint8_t QueuedTDs;				/* general TDs queued, only written by the submitting code */
+	__IO uint8_t RetiredTDs;		/* general TDs retired, written by the ISR and by HcdCancelTransfer() with interrupts masked, QueuedTDs - RetiredTDs are in flight */
 } HCD_EndpointDescriptor, *PHCD_EndpointDescriptor;
 
 typedef struct st_HC_GTD {	// 16 byte align
@@ -317,7 +359,7 @@ typedef struct st_HCD_IsoTransferDescriptor {	// 64 byte align
 }ATTR_ALIGNED(32)  HCD_IsoTransferDescriptor, *PHCD_IsoTransferDescriptor;
 
 /* Memory for OHCI Structures, docs for more information */
-/* For Interrupt Static ED (0 to 62), TailP is used to store the accumulated bandwidth of the list */
+/* Static EDs 0 to 62 are the interrupt tree: list N has lists 2N+1 and 2N+2 above it, 31 to 62 are hooked to HccaIntTable */
 typedef struct st_OHCI_HOST{
 	HC_HCCA	hcca;
 #if ISO_LIST_ENABLE
@@ -326,6 +368,7 @@ typedef struct st_OHCI_HOST{
 	HCD_GeneralTransferDescriptor	gTDs[MAX_GTD];
 	HCD_EndpointDescriptor			EDs[MAX_ED];
 	HC_ED	staticEDs[MAX_STATIC_ED];
+	uint16_t PeriodicBandwidth[32];	/* Reserved periodic bit times of each frame, indexed by frame number % 32 */
 }OHCI_HOST_DATA_Type;
 
 
@@ -366,9 +409,17 @@ static __INLINE HCD_STATUS FreeGtd(PHCD_GeneralTransferDescriptor pGtd);
 static __INLINE HCD_STATUS FreeItd(PHCD_IsoTransferDescriptor pItd);
 static __INLINE HCD_STATUS InsertEndpoint(uint8_t HostID, uint32_t EdIdx, uint8_t ListIndex);
 static __INLINE HCD_STATUS RemoveEndpoint(uint8_t HostID, uint32_t EdIdx);
-/*static __INLINE uint8_t FindInterruptTransferListIndex(uint8_t HostID, uint8_t Interval);*/
+static uint8_t FindInterruptTransferListIndex(uint8_t HostID, uint8_t Interval);
+static bool IsListInFrame(uint8_t ListIdx, uint8_t Frame);
+static uint16_t EndpointBandwidth(uint8_t EdIdx);
+static uint16_t ListPeakBandwidth(uint8_t HostID, uint8_t ListIdx);
+static HCD_STATUS ReservePeriodicBandwidth(uint8_t HostID, uint8_t ListIdx, uint16_t Bandwidth);
+static void ReleasePeriodicBandwidth(uint8_t HostID, uint8_t ListIdx, uint16_t Bandwidth);
+static HCD_STATUS WaitForStartOfFrame(uint8_t HostID);
 static HCD_STATUS QueueOneGTD (uint32_t EdIdx, uint8_t* const CurrentBufferPointer, uint32_t xferLen, uint8_t DirectionPID, uint8_t DataToggle, uint8_t IOC);
 static HCD_STATUS QueueGTDs (uint32_t EdIdx, uint8_t* dataBuff, uint32_t xferLen, uint8_t Direction);
+static HCD_STATUS ReserveGTDs (uint32_t EdIdx, uint32_t TdCount);
+static uint32_t CountGTDs (uint8_t* dataBuff, uint32_t xferLen);
 static HCD_STATUS WaitForTransferComplete( uint8_t EdIdx );
 
 #endif /*defined(__LPC_OHCI__)*/
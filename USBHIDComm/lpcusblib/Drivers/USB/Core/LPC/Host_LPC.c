@@ -44,36 +44,25 @@ void USB_Host_ProcessNextHostState(uint8_t corenum)
 	uint8_t ErrorCode    = HOST_ENUMERROR_NoError;
 	uint8_t SubErrorCode = HOST_ENUMERROR_NoError;
 
-	static uint16_t WaitMSRemaining;
-	static uint8_t  PostWaitState;
+	static USB_Timer_Deadline_t WaitDeadline;
+	static uint8_t              PostWaitState;
 
 	switch (USB_HostState[corenum])
 	{
 		case HOST_STATE_WaitForDevice:
-			if (WaitMSRemaining)
-			{
-				if ((SubErrorCode = USB_Host_WaitMS(1)) != HOST_WAITERROR_Successful)
-				{
-					USB_HostState[corenum] = PostWaitState;
-					ErrorCode     = HOST_ENUMERROR_WaitStage;
-					break;
-				}
-
-				if (!(--WaitMSRemaining))
-				  USB_HostState[corenum] = PostWaitState;
-			}
+			if (USB_Timer_IsExpired(WaitDeadline))
+			  USB_HostState[corenum] = PostWaitState;
 			break;
 
 		case HOST_STATE_Powered:
-			WaitMSRemaining = HOST_DEVICE_SETTLE_DELAY_MS;
+			WaitDeadline = USB_Timer_Deadline(HOST_DEVICE_SETTLE_DELAY_MS);
 
 			USB_HostState[corenum] = HOST_STATE_Powered_WaitForDeviceSettle;
 			break;
 
 		case HOST_STATE_Powered_WaitForDeviceSettle:
-			if (WaitMSRemaining--)
+			if (!(USB_Timer_IsExpired(WaitDeadline)))
 			{
-				Delay_MS(1);
 				break;
 			}
 			else
@@ -89,7 +78,7 @@ void USB_Host_ProcessNextHostState(uint8_t corenum)
 			break;
 
 		case HOST_STATE_Powered_WaitForConnect:
-			HOST_TASK_NONBLOCK_WAIT(corenum, 100, HOST_STATE_Powered_DoReset);
+			HOST_TASK_NONBLOCK_WAIT(corenum, 100 + HOST_PORT_RESET_GUARD_MS, HOST_STATE_Powered_DoReset);
 			break;
 
 		case HOST_STATE_Powered_DoReset:
@@ -98,7 +87,7 @@ void USB_Host_ProcessNextHostState(uint8_t corenum)
 			HcdRhPortReset(corenum,1);
 			HcdGetDeviceSpeed(corenum, 1, &DeviceSpeed); // skip checking status
 			USB_Host_SetDeviceSpeed(corenum,DeviceSpeed);
-			HOST_TASK_NONBLOCK_WAIT(corenum, 200, HOST_STATE_Powered_ConfigPipe);
+			HOST_TASK_NONBLOCK_WAIT(corenum, HOST_PORT_RESET_GUARD_MS + 200, HOST_STATE_Powered_ConfigPipe);
 		}
 			break;
 
@@ -138,7 +127,7 @@ void USB_Host_ProcessNextHostState(uint8_t corenum)
 			Pipe_ClosePipe(corenum, PIPE_CONTROLPIPE);
 			HcdRhPortReset(corenum,1);
 
-			HOST_TASK_NONBLOCK_WAIT(corenum, 200, HOST_STATE_Default_PostReset);
+			HOST_TASK_NONBLOCK_WAIT(corenum, HOST_PORT_RESET_GUARD_MS + 200, HOST_STATE_Default_PostReset);
 		}
 			break;
 
@@ -198,6 +187,10 @@ void USB_Host_ProcessNextHostState(uint8_t corenum)
 
 uint8_t USB_Host_WaitMS(uint8_t MS)
 {
+	USB_Timer_Deadline_t Deadline = USB_Timer_Deadline(MS);
+
+	while (!(USB_Timer_IsExpired(Deadline)));
+
 	return HOST_WAITERROR_Successful;
 }
 
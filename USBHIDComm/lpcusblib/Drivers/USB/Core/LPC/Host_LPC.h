@@ -95,6 +95,17 @@
 				#define HOST_DEVICE_SETTLE_DELAY_MS        1000
 			#endif
 
+			#if !defined(HOST_PORT_RESET_GUARD_MS) || defined(__DOXYGEN__)
+				/** Constant for the delay in milliseconds the library waits before and after resetting the
+				 *  root hub port, without blocking the USB task.
+				 *
+				 *  The default delay value may be overridden in the user project makefile by defining the
+				 *  \c HOST_PORT_RESET_GUARD_MS token to the required delay in milliseconds, and passed to the
+				 *  compiler using the -D switch.
+				 */
+				#define HOST_PORT_RESET_GUARD_MS           400
+			#endif
+
 			/** Enum for the error codes for the \ref EVENT_USB_Host_HostError() event.
 			 *
 			 *  \see \ref Group_Events for more information on this event.
@@ -45,6 +45,18 @@ bool Pipe_ConfigurePipe(const uint8_t corenum,
                         const uint8_t EndpointNumber,
                         const uint16_t Size,
                         const uint8_t Banks)
+{
+	return Pipe_ConfigurePipeInterval(corenum, Number, Type, Token, EndpointNumber, Size, Banks, 1);
+}
+
+bool Pipe_ConfigurePipeInterval(const uint8_t corenum,
+								const uint8_t Number,
+								const uint8_t Type,
+								const uint8_t Token,
+								const uint8_t EndpointNumber,
+								const uint16_t Size,
+								const uint8_t Banks,
+								const uint8_t Interval)
 {
 	if ( HCD_STATUS_OK == HcdOpenPipe(corenum,				/* HostID */
 										((Type == EP_TYPE_CONTROL && USB_HostState[corenum] < HOST_STATE_Default_PostAddressSet)) ? 0 : USB_HOST_DEVICEADDRESS,		/* FIXME DeviceAddr */
@@ -53,7 +65,7 @@ bool Pipe_ConfigurePipe(const uint8_t corenum,
 										(HCD_TRANSFER_TYPE) Type,	/* TransferType */
 										(HCD_TRANSFER_DIR) Token,	/* TransferDir */
 										Size,						/* MaxPacketSize */
-										1,							/* Interval */
+										Interval ? Interval : 1,	/* Interval */
 										1,							/* Mult */
 										0,							/* HSHubDevAddr */
 										0,							/* HSHubPortNum */
@@ -62,7 +74,7 @@ bool Pipe_ConfigurePipe(const uint8_t corenum,
 	{
 		PipeInfo[corenum][Number].ByteTransfered = PipeInfo[corenum][Number].StartIdx = 0;
 		PipeInfo[corenum][Number].BufferSize = (Type == EP_TYPE_BULK || Type == EP_TYPE_CONTROL) ? PIPE_MAX_SIZE : Size; /* XXX Some devices could have configuration descriptor > 235 bytes (eps speaker, webcame). If not deal with those, not need to have such large pipe size for control */
-		PipeInfo[corenum][Number].Buffer = USB_Memory_Alloc( PipeInfo[corenum][Number].BufferSize );
+		PipeInfo[corenum][Number].Buffer = USB_Memory_AllocRegion( PipeInfo[corenum][Number].BufferSize, USBRAM_PIPE_REGION, 4, USB_MEMORY_TAG_Pipe );
 		PipeInfo[corenum][Number].EndponitAddress = EndpointNumber;
 		if (PipeInfo[corenum][Number].Buffer == NULL)
 		{
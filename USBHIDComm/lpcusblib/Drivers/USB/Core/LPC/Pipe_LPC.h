@@ -348,14 +348,19 @@
 				return PipeInfo[corenum][pipeselected[corenum]].EndponitAddress;
 			}
 
-			/** Sets the period between interrupts for an INTERRUPT type pipe to a specified number of milliseconds.
+			/** Sets the period between interrupts for the currently selected INTERRUPT type pipe to a specified
+			 *  number of milliseconds. The host rounds it down to a power of 2, up to 32 ms, and keeps the
+			 *  previous period if the frames of the new one have no bandwidth left.
 			 *
+			 *  \param[in] corenum       USB port number.
 			 *  \param[in] Milliseconds  Number of milliseconds between each pipe poll.
+			 *
+			 *  \return HCD_STATUS_OK if the new period is applied, otherwise the reason the pipe kept its previous one.
 			 */
-			static inline void Pipe_SetInterruptPeriod(const uint8_t Milliseconds) ATTR_ALWAYS_INLINE;
-			static inline void Pipe_SetInterruptPeriod(const uint8_t Milliseconds)
+			static inline HCD_STATUS Pipe_SetInterruptPeriod(const uint8_t corenum, const uint8_t Milliseconds) ATTR_ALWAYS_INLINE;
+			static inline HCD_STATUS Pipe_SetInterruptPeriod(const uint8_t corenum, const uint8_t Milliseconds)
 			{
-				//TODO implement later
+				return HcdSetPipeInterval(PipeInfo[corenum][pipeselected[corenum]].PipeHandle, Milliseconds);
 			}
 
 			/** Returns a mask indicating which pipe's interrupt periods have elapsed, indicating that the pipe should
@@ -868,6 +873,31 @@
 			                        const uint8_t EndpointNumber,
 			                        const uint16_t Size,
 			                        const uint8_t Banks);
+
+			/** Configures a pipe as \ref Pipe_ConfigurePipe() does, opening it with the given polling interval.
+			 *  Interrupt pipes should be opened this way with their endpoint's interval: the host reserves
+			 *  periodic bandwidth when the pipe is opened, and a pipe opened with \ref Pipe_ConfigurePipe() first
+			 *  needs room in every frame before \ref Pipe_SetInterruptPeriod() can move it.
+			 *
+			 *  \param[in] corenum         USB port number.
+			 *  \param[in] Number          Pipe number to configure.
+			 *  \param[in] Type            Type of pipe to configure, an \c EP_TYPE_* mask.
+			 *  \param[in] Token           Pipe data token, either \ref PIPE_TOKEN_SETUP, \ref PIPE_TOKEN_OUT or \ref PIPE_TOKEN_IN.
+			 *  \param[in] EndpointNumber  Endpoint index within the attached device that the pipe should interface to.
+			 *  \param[in] Size            Size of the pipe's bank.
+			 *  \param[in] Banks           Number of banks to use for the pipe, a \c PIPE_BANK_* mask.
+			 *  \param[in] Interval        Polling interval in milliseconds, 0 is taken as 1; only used by periodic pipes.
+			 *
+			 *  \return Boolean \c true if the configuration succeeded, \c false otherwise.
+			 */
+			bool Pipe_ConfigurePipeInterval(const uint8_t corenum,
+			                                const uint8_t Number,
+			                                const uint8_t Type,
+			                                const uint8_t Token,
+			                                const uint8_t EndpointNumber,
+			                                const uint16_t Size,
+			                                const uint8_t Banks,
+			                                const uint8_t Interval);
 			void Pipe_ClosePipe(const uint8_t corenum, uint8_t pipenum);
 			/** Spin-loops until the currently selected non-control pipe is ready for the next packed of data to be read
 			 *  or written to it, aborting in the case of an error condition (such as a timeout or device disconnect).
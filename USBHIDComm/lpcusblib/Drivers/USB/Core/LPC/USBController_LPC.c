@@ -37,6 +37,8 @@ uint8_t USBPortNum;
 
 void USB_Init(void)
 {
+	USB_Timer_Init();
+
 #if defined(USB_MULTI_PORTS)
 	uint8_t i;
 	USB_Memory_Init(USBRAM_BUFFER_SIZE);
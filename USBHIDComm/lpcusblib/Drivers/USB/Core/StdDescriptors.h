@@ -93,6 +93,25 @@
 			 */
 			#define USB_STRING_LEN(UnicodeChars)      (sizeof(USB_Descriptor_Header_t) + ((UnicodeChars) << 1))
 
+			/** Macro to calculate the size in bytes of a string descriptor holding the given characters, so the length
+			 *  does not have to be counted by hand.
+			 *
+			 *  \param[in] ...  Comma separated list of characters or language IDs in the string.
+			 */
+			#define USB_STRING_DESCRIPTOR_SIZE(...)   (sizeof(USB_Descriptor_Header_t) + sizeof((uint16_t[]){__VA_ARGS__}))
+
+			/** Macro to initialize a constant \ref USB_Descriptor_String_t with the given characters, stored as UTF-16LE
+			 *  code units with the descriptor size filled in. For example:
+			 *  \code
+			 *  const USB_Descriptor_String_t PROGMEM ProductString = USB_STRING_DESCRIPTOR('L', 'P', 'C');
+			 *  \endcode
+			 *
+			 *  \param[in] ...  Comma separated list of characters or language IDs in the string.
+			 */
+			#define USB_STRING_DESCRIPTOR(...)        { .Header        = {.Size = USB_STRING_DESCRIPTOR_SIZE(__VA_ARGS__), \
+			                                                              .Type = DTYPE_String},                           \
+			                                            .UnicodeString = {__VA_ARGS__} }
+
 			/** Macro to encode a given four digit floating point version number (e.g. 01.23) into Binary Coded
 			 *  Decimal format for descriptor fields requiring BCD encoding, such as the USB version number in the
 			 *  standard device descriptor.
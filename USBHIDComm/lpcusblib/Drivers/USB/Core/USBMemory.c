@@ -37,11 +37,34 @@
 /* LOCAL SYMBOL DECLARATIION                                            */
 /************************************************************************/
 typedef struct MemBlockInfo_t {
-	uint32_t size :15; // memory size of this block
+	uint32_t size :20; // memory size of this block
 	uint32_t isFree :1; // indicate whether this memory block is free or used
-	uint32_t next :16; // offset (from head address) to the next block
+	uint32_t reserved :3;
+	uint32_t tag :8; // caller tag of the allocation
+	uint32_t next :20; // offset in bytes (from head address) to the next block
+	uint32_t guard :12; // header guard pattern
 } sMemBlockInfo, *PMemBlockInfo;
 
+typedef struct MemFreeNode_t {
+	struct MemFreeNode_t *next; // next free block of the same size class
+} sMemFreeNode, *PMemFreeNode;
+
+typedef struct MemSizeClass_t {
+	uint8_t *start; // first block of this class
+	uint8_t *end; // one past the last block of this class
+	uint32_t blockSize; // usable size of every block of this class
+	uint32_t stride; // distance between two blocks, blockSize plus guard word
+	uint8_t *tags; // per block caller tag, MEM_TAG_FREE when on the free list
+	uint16_t freeCount; // number of blocks on the free list
+	PMemFreeNode freeList; // LIFO list of free blocks
+} sMemSizeClass, *PMemSizeClass;
+
+typedef struct MemRegion_t {
+	uint8_t *start; // pool buffer of this region
+	uint32_t size; // size of the pool buffer
+	uint8_t *heap; // general heap of this region, NULL when empty
+} sMemRegion, *PMemRegion;
+
 /************************************************************************/
 /* LOCAL DEFINE                                                         */
 /************************************************************************/
@@ -51,50 +74,236 @@ typedef struct MemBlockInfo_t {
 
 #define  HEADER_SIZE                (sizeof(sMemBlockInfo))
 #define  HEADER_POINTER(x)          ((uint8_t *)x - sizeof(sMemBlockInfo))
-#define  NEXT_BLOCK(x)            ( ((PMemBlockInfo) ( ((x)->next==0) ? NULL : head + (x)->next )) )
-#define  LINK_TO_THIS_BLOCK(x)    ( ((uint32_t) ((x)-head)) )
+#define  NEXT_BLOCK(x)            ( ((PMemBlockInfo) ( ((x)->next==0) ? NULL : (uint8_t *) head + (x)->next )) )
+#define  LINK_TO_THIS_BLOCK(x)    ( ((uint32_t) ((uint8_t *) (x) - (uint8_t *) head)) )
+
+/* Size classes, largest first so that every block keeps the alignment of the pool */
+#define  SIZE_CLASS_SCRATCH_SIZE    (256)
+#define  SIZE_CLASS_NUM             (3)
+#define  SIZE_CLASS_TOTAL_BLOCKS    (USBRAM_POOL_PIPE_BLOCKS + USBRAM_POOL_SCRATCH_BLOCKS + USBRAM_POOL_PACKET_BLOCKS)
+
+#define  MEM_TAG_FREE               (0xFF)
+#define  MEM_HEADER_GUARD           (0xA5C)
+#define  MEM_TAIL_GUARD             (0xDEADBEEFUL)
+
+#if defined(USB_MEMORY_DEBUG)
+	#define  GUARD_SIZE             (sizeof(uint32_t)) // tail guard word behind every allocation
+#else
+	#define  GUARD_SIZE             (0)
+#endif
+
+#if (USBRAM2_BUFFER_SIZE > 0) && !defined(USBRAM2_SECTION)
+	#error USBRAM2_BUFFER_SIZE requires a USBRAM2_SECTION for the selected architecture.
+#endif
 
 PRAGMA_ALIGN_4
 static uint8_t USB_Mem_Buffer[USBRAM_BUFFER_SIZE] ATTR_ALIGNED(4) __DATA(USBRAM_SECTION);
 
-/************************************************************************
- Function    : lpc_memory_init
- Parameters  : void
- Returns     : void
- Description : This function initializes memory pool manager
- ************************************************************************/
-void USB_Memory_Init(uint32_t Memory_Pool_Size)
+#if (USBRAM2_BUFFER_SIZE > 0)
+PRAGMA_ALIGN_4
+static uint8_t USB_Mem_Buffer2[USBRAM2_BUFFER_SIZE] ATTR_ALIGNED(4) __DATA(USBRAM2_SECTION);
+#endif
+
+static sMemRegion MemRegion[USB_MEMORY_REGIONS];
+
+static sMemSizeClass SizeClass[SIZE_CLASS_NUM] = {
+	{.blockSize = PIPE_MAX_SIZE},
+	{.blockSize = SIZE_CLASS_SCRATCH_SIZE},
+	{.blockSize = FIXED_CONTROL_ENDPOINT_SIZE},
+};
+
+static const uint16_t SizeClassBlocks[SIZE_CLASS_NUM] = {
+	USBRAM_POOL_PIPE_BLOCKS,
+	USBRAM_POOL_SCRATCH_BLOCKS,
+	USBRAM_POOL_PACKET_BLOCKS,
+};
+
+static uint8_t SizeClassTags[SIZE_CLASS_TOTAL_BLOCKS + 1];
+
+static USB_Memory_Stats_t MemStats;
+
+/************************************************************************/
+/* LOCAL FUNCTIONS                                                      */
+/************************************************************************/
+static void MemStats_Alloc(uint8_t tag, uint32_t bytes)
+{
+	MemStats.CurrentUsage += bytes;
+	MemStats.TagUsage[tag] += bytes;
+	if (MemStats.CurrentUsage > MemStats.PeakUsage) {
+		MemStats.PeakUsage = MemStats.CurrentUsage;
+	}
+}
+
+static void MemStats_Free(uint8_t tag, uint32_t bytes)
+{
+	MemStats.CurrentUsage -= bytes;
+	MemStats.TagUsage[tag] -= bytes;
+}
+
+#if defined(USB_MEMORY_DEBUG)
+static void MemGuard_Set(uint8_t *ptr, uint32_t size)
+{
+	uint32_t guard = MEM_TAIL_GUARD;
+	memcpy(ptr + size, &guard, GUARD_SIZE);
+}
+
+static void MemGuard_Check(uint8_t *ptr, uint32_t size)
+{
+	uint32_t guard;
+	memcpy(&guard, ptr + size, GUARD_SIZE);
+	if (guard != MEM_TAIL_GUARD) {
+		MemStats.GuardErrors++;
+	}
+}
+#endif
+
+/* Carve the fixed size blocks of every class out of the start of a pool buffer,
+ * returns the number of bytes used */
+static uint32_t MemClass_Init(uint8_t *blk_ptr, uint32_t remain)
+{
+	uint8_t *tag_ptr = SizeClassTags;
+	uint32_t i, count, used = 0;
+
+	for (i = 0; i < SIZE_CLASS_NUM; i++)
+	{
+		PMemSizeClass sc = &SizeClass[i];
+
+		sc->stride = sc->blockSize + GUARD_SIZE;
+		count = SizeClassBlocks[i];
+		if (count > (remain - used) / sc->stride) {
+			count = (remain - used) / sc->stride;
+		}
+
+		sc->start = blk_ptr;
+		sc->tags = tag_ptr;
+		sc->freeCount = count;
+		sc->freeList = NULL;
+		while (count--)
+		{
+			*tag_ptr++ = MEM_TAG_FREE;
+			((PMemFreeNode) blk_ptr)->next = sc->freeList;
+			sc->freeList = (PMemFreeNode) blk_ptr;
+			blk_ptr += sc->stride;
+			used += sc->stride;
+		}
+		sc->end = blk_ptr;
+	}
+
+	return used;
+}
+
+/* Smallest class that fits, O(1) pop from its free list */
+static uint8_t* MemClass_Alloc(uint32_t size, uint32_t align, uint8_t tag)
 {
-	PMemBlockInfo head = (PMemBlockInfo) USB_Mem_Buffer;
+	int32_t i;
 
+	for (i = SIZE_CLASS_NUM - 1; i >= 0; i--)
+	{
+		PMemSizeClass sc = &SizeClass[i];
+
+		if (size <= sc->blockSize)
+		{
+			PMemFreeNode node = sc->freeList;
+			if ((node != NULL) && (((uint32_t) node & (align - 1)) == 0))
+			{
+				sc->freeList = node->next;
+				sc->freeCount--;
+				sc->tags[((uint8_t *) node - sc->start) / sc->stride] = tag;
+				MemStats_Alloc(tag, sc->stride);
+#if defined(USB_MEMORY_DEBUG)
+				MemGuard_Set((uint8_t *) node, sc->blockSize);
+#endif
+				return ((uint8_t *) node);
+			}
+			break;
+		}
+	}
+
+	return ((uint8_t *) NULL);
+}
+
+/* Class blocks are identified by address range, O(1) push back to the free list */
+static bool MemClass_Free(uint8_t *ptr)
+{
+	uint32_t i;
+
+	for (i = 0; i < SIZE_CLASS_NUM; i++)
+	{
+		PMemSizeClass sc = &SizeClass[i];
+
+		if ((ptr >= sc->start) && (ptr < sc->end))
+		{
+			uint8_t *tag = &sc->tags[(ptr - sc->start) / sc->stride];
+
+			if (*tag == MEM_TAG_FREE) {
+				MemStats.DoubleFrees++;
+				return true;
+			}
+#if defined(USB_MEMORY_DEBUG)
+			MemGuard_Check(ptr, sc->blockSize);
+#endif
+			MemStats_Free(*tag, sc->stride);
+			*tag = MEM_TAG_FREE;
+			((PMemFreeNode) ptr)->next = sc->freeList;
+			sc->freeList = (PMemFreeNode) ptr;
+			sc->freeCount++;
+			return true;
+		}
+	}
+
+	return false;
+}
+
+static void MemHeap_Init(PMemRegion region, uint8_t *start, uint32_t size)
+{
+	PMemBlockInfo head = (PMemBlockInfo) start;
+
+	/* Whatever is left becomes the general heap */
+	if (size <= HEADER_SIZE + GUARD_SIZE) {
+		region->heap = NULL;
+		return;
+	}
+
+	region->heap = start;
 	head->next = 0;
-	head->size = (Memory_Pool_Size & 0xfffffffc) - HEADER_SIZE ;// align memory size
+	head->size = size - HEADER_SIZE ;// align memory size
 	head->isFree = 1;
+	head->tag = MEM_TAG_FREE;
+	head->guard = MEM_HEADER_GUARD;
 }
 
-/************************************************************************
- Function    : lpc_malloc
- Parameters  : unsigned int    - memory block size
- Returns     : uint8_t *  - Pointer to memory block or NULL
- Description : This function allocates a memory block for the given size
- from memory pool segment
- ************************************************************************/
-uint8_t* USB_Memory_Alloc(uint32_t size)
+/* Bytes to skip in front of a free block so that its payload is aligned, the
+ * skipped bytes must be able to hold a free block of their own */
+static uint32_t MemHeap_Padding(PMemBlockInfo blk_ptr, uint32_t align)
+{
+	uint32_t pad = (0 - ((uint32_t) blk_ptr + HEADER_SIZE)) & (align - 1);
+
+	while ((pad != 0) && (pad < HEADER_SIZE + ALIGN_FOUR_BYTES)) {
+		pad += align;
+	}
+	return pad;
+}
+
+static uint8_t* MemHeap_Alloc(PMemRegion region, uint32_t size, uint32_t align, uint8_t tag)
 {
 	PMemBlockInfo freeBlock, newBlock, blk_ptr = NULL;
-	PMemBlockInfo head = (PMemBlockInfo) USB_Mem_Buffer;
+	PMemBlockInfo head = (PMemBlockInfo) region->heap;
+	uint32_t pad = 0;
 
-	/* Align the requested size by 4 bytes */
-	if ((size % ALIGN_FOUR_BYTES) != 0) {
-		size = (((size >> 2) << 2) + ALIGN_FOUR_BYTES);
+	if (head == NULL) {
+		return ((uint8_t *) NULL);
 	}
 
 	for (freeBlock = head; freeBlock != NULL; freeBlock = NEXT_BLOCK(freeBlock)) // 1st-fit technique
 	{
-		if ((freeBlock->isFree == 1) && (freeBlock->size >= size))
+		if (freeBlock->isFree == 1)
 		{
-			blk_ptr = freeBlock;
-			break;
+			pad = MemHeap_Padding(freeBlock, align);
+			if (freeBlock->size >= pad + size)
+			{
+				blk_ptr = freeBlock;
+				break;
+			}
 		}
 	}
 
@@ -102,6 +311,19 @@ uint8_t* USB_Memory_Alloc(uint32_t size)
 		return ((uint8_t *) NULL);
 	}
 
+	if (pad != 0) // leave the alignment padding behind as a free block of its own
+	{
+		freeBlock = (PMemBlockInfo) (((uint8_t *) blk_ptr) + pad);
+		freeBlock->next = blk_ptr->next;
+		freeBlock->size = blk_ptr->size - pad;
+		freeBlock->isFree = 1;
+		freeBlock->guard = MEM_HEADER_GUARD;
+
+		blk_ptr->size = pad - HEADER_SIZE;
+		blk_ptr->next = LINK_TO_THIS_BLOCK(freeBlock);
+		blk_ptr = freeBlock;
+	}
+
 	if (blk_ptr->size <= HEADER_SIZE + size) // where (blk_size=size | blk_size=size+HEAD) then allocate whole block & do not create freeBlock
 	{
 		newBlock = blk_ptr;
@@ -114,6 +336,8 @@ uint8_t* USB_Memory_Alloc(uint32_t size)
 		freeBlock->next = blk_ptr->next;
 		freeBlock->size = blk_ptr->size - (HEADER_SIZE + size);
 		freeBlock->isFree = 1;
+		freeBlock->tag = MEM_TAG_FREE;
+		freeBlock->guard = MEM_HEADER_GUARD;
 
 		/* Locate new block at start of found block */
 		newBlock = blk_ptr;
@@ -121,29 +345,42 @@ uint8_t* USB_Memory_Alloc(uint32_t size)
 		newBlock->next = LINK_TO_THIS_BLOCK(freeBlock);
 		newBlock->isFree = 0;
 	}
+	newBlock->tag = tag;
+	newBlock->guard = MEM_HEADER_GUARD;
+	MemStats_Alloc(tag, newBlock->size + HEADER_SIZE);
+#if defined(USB_MEMORY_DEBUG)
+	MemGuard_Set(((uint8_t *) newBlock) + HEADER_SIZE, newBlock->size - GUARD_SIZE);
+#endif
 
 	return (((uint8_t *) newBlock) + HEADER_SIZE);
 }
 
-/************************************************************************
- Function    : lpc_free
- Parameters  : uint8_t *  - Pointer to memory block
- Returns     : None
- Description : This function frees up the given memory block and does
- packing of fragmented blocks
- ************************************************************************/
-void USB_Memory_Free(uint8_t *ptr)
+static void MemHeap_Free(PMemRegion region, uint8_t *ptr)
 {
 	PMemBlockInfo prev;
-	PMemBlockInfo head = (PMemBlockInfo) USB_Mem_Buffer;
+	PMemBlockInfo head = (PMemBlockInfo) region->heap;
 	PMemBlockInfo blk_ptr;
 
-	if (ptr == NULL)
-	{
+	blk_ptr = (PMemBlockInfo) HEADER_POINTER(ptr);
+
+	/* Checked before the guard, a freed header has its guard cleared */
+	if (blk_ptr->isFree == 1) {
+		MemStats.DoubleFrees++;
 		return;
 	}
-
-	blk_ptr = (PMemBlockInfo) HEADER_POINTER(ptr);
+#if defined(USB_MEMORY_DEBUG)
+	if (blk_ptr->guard != MEM_HEADER_GUARD) {
+		MemStats.GuardErrors++;
+		return;
+	}
+	MemGuard_Check(ptr, blk_ptr->size - GUARD_SIZE);
+#endif
+	MemStats_Free(blk_ptr->tag, blk_ptr->size + HEADER_SIZE);
+	blk_ptr->tag = MEM_TAG_FREE;
+	/* Mark the header before merging: if it is absorbed by the previous free block
+	 * a second free of the same pointer must still be caught */
+	blk_ptr->isFree = 1;
+	blk_ptr->guard = 0;
 
 	if (blk_ptr->next != 0) // merge with next free block
 	{
@@ -167,10 +404,177 @@ void USB_Memory_Free(uint8_t *ptr)
 			break;
 		}
 	}
+}
 
-	blk_ptr->isFree = 1;
+/************************************************************************
+ Function    : lpc_memory_init
+ Parameters  : void
+ Returns     : void
+ Description : This function initializes memory pool manager. The size
+ classes and the first heap live in region 0, the optional
+ second region only holds a heap
+ ************************************************************************/
+void USB_Memory_Init(uint32_t Memory_Pool_Size)
+{
+	uint32_t size = Memory_Pool_Size & 0xfffffffc;
+	uint32_t used;
+
+	memset(&MemStats, 0, sizeof(MemStats));
+
+	MemRegion[0].start = USB_Mem_Buffer;
+	MemRegion[0].size = size;
+	used = MemClass_Init(USB_Mem_Buffer, size);
+	MemHeap_Init(&MemRegion[0], USB_Mem_Buffer + used, size - used);
+	MemStats.PoolSize = size;
+
+#if (USBRAM2_BUFFER_SIZE > 0)
+	size = USBRAM2_BUFFER_SIZE & 0xfffffffc;
+	MemRegion[1].start = USB_Mem_Buffer2;
+	MemRegion[1].size = size;
+	MemHeap_Init(&MemRegion[1], USB_Mem_Buffer2, size);
+	MemStats.PoolSize += size;
+#endif
+}
+
+/************************************************************************
+ Function    : lpc_malloc
+ Parameters  : unsigned int    - memory block size
+ Returns     : uint8_t *  - Pointer to memory block or NULL
+ Description : This function allocates an untagged memory block
+ ************************************************************************/
+uint8_t* USB_Memory_Alloc(uint32_t size)
+{
+	return USB_Memory_AllocRegion(size, USB_MEMORY_REGION_Any, ALIGN_FOUR_BYTES, USB_MEMORY_TAG_None);
+}
+
+/************************************************************************
+ Function    : lpc_malloc_tagged
+ Parameters  : unsigned int    - memory block size
+               uint8_t         - caller tag the block is accounted to
+ Returns     : uint8_t *  - Pointer to memory block or NULL
+ Description : This function allocates a tagged memory block
+ ************************************************************************/
+uint8_t* USB_Memory_AllocTagged(uint32_t size, uint8_t tag)
+{
+	return USB_Memory_AllocRegion(size, USB_MEMORY_REGION_Any, ALIGN_FOUR_BYTES, tag);
+}
+
+/************************************************************************
+ Function    : lpc_malloc_region
+ Parameters  : unsigned int    - memory block size
+               uint8_t         - region to allocate from or USB_MEMORY_REGION_Any
+               unsigned int    - alignment of the block, power of two
+               uint8_t         - caller tag the block is accounted to
+ Returns     : uint8_t *  - Pointer to memory block or NULL
+ Description : This function allocates a memory block for the given size
+ from the matching size class, or from the general heap of the
+ region when no class fits or the class is exhausted
+ ************************************************************************/
+uint8_t* USB_Memory_AllocRegion(uint32_t size, uint8_t region, uint32_t align, uint8_t tag)
+{
+	uint8_t *ptr = NULL;
+	uint8_t i;
+
+	if (tag >= USB_MEMORY_MAX_TAGS) {
+		tag = USB_MEMORY_TAG_None;
+	}
+	if (align < ALIGN_FOUR_BYTES) {
+		align = ALIGN_FOUR_BYTES;
+	}
+
+	/* Align the requested size by 4 bytes */
+	if ((size % ALIGN_FOUR_BYTES) != 0) {
+		size = (((size >> 2) << 2) + ALIGN_FOUR_BYTES);
+	}
+
+	if ((region == 0) || (region == USB_MEMORY_REGION_Any)) {
+		ptr = MemClass_Alloc(size, align, tag);
+	}
+
+	for (i = 0; (ptr == NULL) && (i < USB_MEMORY_REGIONS); i++)
+	{
+		if ((region == i) || (region == USB_MEMORY_REGION_Any)) {
+			ptr = MemHeap_Alloc(&MemRegion[i], size + GUARD_SIZE, align, tag);
+		}
+	}
+
+	if (ptr == NULL) {
+		MemStats.AllocFailures++;
+	}
+	return ptr;
+}
+
+/************************************************************************
+ Function    : lpc_free
+ Parameters  : uint8_t *  - Pointer to memory block
+ Returns     : None
+ Description : This function frees up the given memory block and does
+ packing of fragmented blocks
+ ************************************************************************/
+void USB_Memory_Free(uint8_t *ptr)
+{
+	uint8_t i;
+
+	if (ptr == NULL)
+	{
+		return;
+	}
+
+	if (MemClass_Free(ptr)) {
+		return;
+	}
+
+	for (i = 0; i < USB_MEMORY_REGIONS; i++)
+	{
+		if ((ptr >= MemRegion[i].start) && (ptr < MemRegion[i].start + MemRegion[i].size))
+		{
+			MemHeap_Free(&MemRegion[i], ptr);
+			return;
+		}
+	}
 
 	return;
 }
 
+/************************************************************************
+ Function    : lpc_memory_stats
+ Parameters  : USB_Memory_Stats_t *  - Pointer to the statistics to fill
+ Returns     : None
+ Description : This function reports usage counters of the memory pool
+ and walks the general heaps to measure their fragmentation
+ ************************************************************************/
+void USB_Memory_GetStats(USB_Memory_Stats_t* const Stats)
+{
+	PMemBlockInfo blk_ptr;
+	PMemBlockInfo head;
+	uint32_t i;
+
+	*Stats = MemStats;
+	Stats->LargestFreeBlock = 0;
+	Stats->FreeBlockCount = 0;
+
+	for (i = 0; i < SIZE_CLASS_NUM; i++)
+	{
+		Stats->FreeBlockCount += SizeClass[i].freeCount;
+		if ((SizeClass[i].freeCount != 0) && (SizeClass[i].blockSize > Stats->LargestFreeBlock)) {
+			Stats->LargestFreeBlock = SizeClass[i].blockSize;
+		}
+	}
+
+	for (i = 0; i < USB_MEMORY_REGIONS; i++)
+	{
+		head = (PMemBlockInfo) MemRegion[i].heap;
+		for (blk_ptr = head; blk_ptr != NULL; blk_ptr = NEXT_BLOCK(blk_ptr))
+		{
+			if (blk_ptr->isFree == 1)
+			{
+				Stats->FreeBlockCount++;
+				if (blk_ptr->size - GUARD_SIZE > Stats->LargestFreeBlock) {
+					Stats->LargestFreeBlock = blk_ptr->size - GUARD_SIZE;
+				}
+			}
+		}
+	}
+}
+
 #endif
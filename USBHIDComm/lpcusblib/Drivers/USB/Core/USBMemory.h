@@ -34,9 +34,56 @@
 /* Includes: */
 #include "../../../Common/Common.h"
 
+/* Macros: */
+/** Number of caller tags the pool keeps separate usage counters for. */
+#define USB_MEMORY_MAX_TAGS           8
+
+/** Number of memory regions making up the pool. Region 0 is the buffer placed in USBRAM_SECTION,
+ *  region 1 exists when USBRAM2_BUFFER_SIZE is non zero and is placed in USBRAM2_SECTION.
+ */
+#if (USBRAM2_BUFFER_SIZE > 0)
+	#define USB_MEMORY_REGIONS        2
+#else
+	#define USB_MEMORY_REGIONS        1
+#endif
+
+/** Region argument of \ref USB_Memory_AllocRegion() allowing the block to be placed in any region. */
+#define USB_MEMORY_REGION_Any         0xFF
+
+/* Enums: */
+/** Caller tags accepted by \ref USB_Memory_AllocTagged(), so pool usage can be broken down by user.
+ *  Applications may use any value from \ref USB_MEMORY_TAG_Application up to \ref USB_MEMORY_MAX_TAGS - 1.
+ */
+enum USB_Memory_Tags_t
+{
+	USB_MEMORY_TAG_None        = 0, /**< Untagged allocation, as made by \ref USB_Memory_Alloc(). */
+	USB_MEMORY_TAG_Pipe        = 1, /**< Pipe buffer allocated by \ref Pipe_ConfigurePipe(). */
+	USB_MEMORY_TAG_Application = 2, /**< First tag free for application use. */
+};
+
+/* Type Defines: */
+/** Snapshot of the USB RAM pool usage, filled by \ref USB_Memory_GetStats(). All sizes are in bytes
+ *  and include the per block overhead of the allocator.
+ */
+typedef struct
+{
+	uint32_t PoolSize;         /**< Total size of the pool. */
+	uint32_t CurrentUsage;     /**< Bytes currently allocated. */
+	uint32_t PeakUsage;        /**< Highest value of CurrentUsage since \ref USB_Memory_Init(). */
+	uint32_t LargestFreeBlock; /**< Largest request that can currently be served. */
+	uint16_t FreeBlockCount;   /**< Number of free size class blocks and free heap fragments. */
+	uint16_t AllocFailures;    /**< Number of allocations that returned NULL. */
+	uint16_t DoubleFrees;      /**< Number of frees of a block that was not allocated. */
+	uint16_t GuardErrors;      /**< Number of corrupted guard words found on free, USB_MEMORY_DEBUG only. */
+	uint32_t TagUsage[USB_MEMORY_MAX_TAGS]; /**< Bytes currently allocated per caller tag. */
+} USB_Memory_Stats_t;
+
 /* Function Prototypes: */
 void USB_Memory_Init(uint32_t Memory_Pool_Size);
 uint8_t* USB_Memory_Alloc(uint32_t size);
+uint8_t* USB_Memory_AllocTagged(uint32_t size, uint8_t tag);
+uint8_t* USB_Memory_AllocRegion(uint32_t size, uint8_t region, uint32_t align, uint8_t tag);
 void USB_Memory_Free(uint8_t *ptr);
+void USB_Memory_GetStats(USB_Memory_Stats_t* const Stats);
 
 #endif /* __USBMEMORY_H__ */
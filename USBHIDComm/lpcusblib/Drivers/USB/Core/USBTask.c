@@ -62,6 +62,9 @@ void USB_USBTask(void)
 #if defined(USB_CAN_BE_DEVICE)
 static void USB_DeviceTask(void)
 {
+	#if defined(INTERRUPT_CONTROL_ENDPOINT) && (defined(__LPC17XX__) || defined(__LPC177X_8X__))
+	/* Control requests are processed from the USB interrupt */
+	#else
 	if (USB_DeviceState != DEVICE_STATE_Unattached)
 	{
 		uint8_t PrevEndpoint = Endpoint_GetCurrentEndpoint();
@@ -73,6 +76,7 @@ static void USB_DeviceTask(void)
 
 		Endpoint_SelectEndpoint(PrevEndpoint);
 	}
+	#endif
 }
 #endif
 
@@ -51,6 +51,7 @@
 		#include "Events.h"
 		#include "StdRequestType.h"
 		#include "StdDescriptors.h"
+		#include "USBTimer.h"
 
 		#if defined(USB_CAN_BE_DEVICE)
 			#include "DeviceStandardReq.h"
@@ -194,7 +195,7 @@
 
 		/* Macros: */
 			#define HOST_TASK_NONBLOCK_WAIT(CoreID, Duration, NextState) MACROS{ USB_HostState[(CoreID)]   = HOST_STATE_WaitForDevice; \
-			                                                             WaitMSRemaining = (Duration);               \
+			                                                             WaitDeadline    = USB_Timer_Deadline(Duration); \
 			                                                             PostWaitState   = (NextState);              }MACROE
 	#endif
 
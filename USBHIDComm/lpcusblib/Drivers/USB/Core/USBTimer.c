@@ -0,0 +1,208 @@
+/*
+* Copyright(C) 2011, NXP Semiconductor
+* All rights reserved.
+*
+*         LUFA Library
+* Copyright (C) Dean Camera, 2011.
+*
+* Software that is described herein is for illustrative purposes only
+* which provides customers with programming information regarding the
+* products. This software is supplied "AS IS" without any warranties.
+* NXP Semiconductors assumes no responsibility or liability for the
+* use of the software, conveys no license or title under any patent,
+* copyright, or mask work right to the product. NXP Semiconductors
+* reserves the right to make changes in the software without
+* notification. NXP Semiconductors also make no representation or
+* warranty that such application will be suitable for the specified
+* use without further testing or modification.
+*
+* Permission to use, copy, modify, and distribute this software
+* and its documentation for any purpose is hereby granted without
+* fee, provided that it is used in conjunction with NXP Semiconductors
+* microcontrollers.  This copyright, permission, and disclaimer notice
+* must appear in all copies of this code.
+*/
+
+#define  __INCLUDE_FROM_USB_DRIVER
+#include "USBMode.h"
+
+#include "../../../Common/Common.h"
+#include "USBTask.h"
+#include "LPC/HAL/HAL_LPC.h"
+#include "USBTimer.h"
+
+volatile uint32_t USB_Timer_Ticks;
+
+/* Active software timers, ordered by expiry */
+static USB_Timer_t* TimerList;
+
+static void InsertTimer(USB_Timer_t* const Timer)
+{
+	USB_Timer_t** Link = &TimerList;
+
+	while ((*Link != NULL) && ((int32_t)((*Link)->Expiry - Timer->Expiry) <= 0))
+	{
+		Link = &(*Link)->Next;
+	}
+
+	Timer->Next = *Link;
+	*Link = Timer;
+}
+
+static void RemoveTimer(USB_Timer_t* const Timer)
+{
+	USB_Timer_t** Link = &TimerList;
+
+	while (*Link != NULL)
+	{
+		if (*Link == Timer)
+		{
+			*Link = Timer->Next;
+			break;
+		}
+		Link = &(*Link)->Next;
+	}
+}
+
+void USB_Timer_Init(void)
+{
+#if !defined(USB_TIMER_EXTERNAL_TICK)
+	SysTick_Config(SystemCoreClock / USB_TIMER_TICK_HZ);
+#endif
+}
+
+void USB_Timer_Tick(void)
+{
+	uint32_t Now = ++USB_Timer_Ticks;
+
+	while ((TimerList != NULL) && ((int32_t)(Now - TimerList->Expiry) >= 0))
+	{
+		USB_Timer_t* Timer = TimerList;
+
+		TimerList = Timer->Next;
+		if (Timer->Period)
+		{
+			Timer->Expiry += Timer->Period;
+			InsertTimer(Timer);
+		}
+		else
+		{
+			Timer->Active = false;
+		}
+
+		Timer->Callback(Timer->Context);
+	}
+}
+
+#if !defined(USB_TIMER_EXTERNAL_TICK)
+void SysTick_Handler(void)
+{
+	USB_Timer_Tick();
+}
+#endif
+
+uint32_t USB_Timer_GetUS(void)
+{
+	uint32_t Ticks;
+	uint32_t Count;
+	uint32_t Pending;
+
+	/* Re-read if the tick interrupt ran between the reads */
+	do
+	{
+		Ticks   = USB_Timer_Ticks;
+		Count   = SysTick->VAL;
+		Pending = SCB->ICSR & SCB_ICSR_PENDSTSET_Msk;
+
+		/* Reloaded but not ticked yet, as when called with the tick interrupt blocked. Count may
+		 * be from before the reload, read it again */
+		if (Pending)
+		  Count = SysTick->VAL;
+	} while (Ticks != USB_Timer_Ticks);
+
+	if (Pending)
+	  Ticks++;
+
+	return (Ticks * (1000000 / USB_TIMER_TICK_HZ)) +
+	       ((SysTick->LOAD - Count) / (SystemCoreClock / 1000000));
+}
+
+void USB_Timer_StartCountdown(USB_Timer_Countdown_t* const Countdown, uint32_t Microseconds)
+{
+	uint32_t CyclesPerUS = SystemCoreClock / 1000000;
+
+	if (Microseconds > (UINT32_MAX / CyclesPerUS))
+	  Microseconds = UINT32_MAX / CyclesPerUS; /* Clamped to 2^32 core clock cycles */
+
+	Countdown->Remaining = Microseconds * CyclesPerUS;
+	Countdown->Last      = SysTick->VAL;
+}
+
+bool USB_Timer_CountdownExpired(USB_Timer_Countdown_t* const Countdown)
+{
+	uint32_t Reload  = SysTick->LOAD + 1;
+	uint32_t Now     = SysTick->VAL;
+	uint32_t Elapsed = (Countdown->Last >= Now) ? (Countdown->Last - Now) : (Countdown->Last + Reload - Now); /* SysTick counts down */
+
+	if (Elapsed >= Countdown->Remaining)
+	{
+		Countdown->Remaining = 0;
+		return true;
+	}
+
+	Countdown->Remaining -= Elapsed;
+	Countdown->Last       = Now;
+	return false;
+}
+
+void USB_Timer_DelayUS(uint32_t Microseconds)
+{
+	USB_Timer_Countdown_t Countdown;
+
+	USB_Timer_StartCountdown(&Countdown, Microseconds);
+	while (!(USB_Timer_CountdownExpired(&Countdown)));
+}
+
+void USB_Timer_DelayMS(uint32_t Milliseconds)
+{
+	while (Milliseconds--)
+	{
+		USB_Timer_DelayUS(1000);
+	}
+}
+
+void USB_Timer_Start(USB_Timer_t* const Timer,
+                     const uint32_t Delay,
+                     const uint32_t Period,
+                     USB_Timer_Callback_t Callback,
+                     void* const Context)
+{
+	uint32_t CurrentPriMask = __get_PRIMASK();
+
+	__disable_irq();
+	if (Timer->Active)
+	{
+		RemoveTimer(Timer);
+	}
+
+	Timer->Expiry   = USB_Timer_Ticks + Delay;
+	Timer->Period   = Period;
+	Timer->Callback = Callback;
+	Timer->Context  = Context;
+	Timer->Active   = true;
+	InsertTimer(Timer);
+	__set_PRIMASK(CurrentPriMask);
+}
+
+void USB_Timer_Stop(USB_Timer_t* const Timer)
+{
+	uint32_t CurrentPriMask = __get_PRIMASK();
+
+	__disable_irq();
+	if (Timer->Active)
+	{
+		RemoveTimer(Timer);
+		Timer->Active = false;
+	}
+	__set_PRIMASK(CurrentPriMask);
+}
@@ -0,0 +1,188 @@
+/*
+* Copyright(C) 2011, NXP Semiconductor
+* All rights reserved.
+*
+*         LUFA Library
+* Copyright (C) Dean Camera, 2011.
+*
+* Software that is described herein is for illustrative purposes only
+* which provides customers with programming information regarding the
+* products. This software is supplied "AS IS" without any warranties.
+* NXP Semiconductors assumes no responsibility or liability for the
+* use of the software, conveys no license or title under any patent,
+* copyright, or mask work right to the product. NXP Semiconductors
+* reserves the right to make changes in the software without
+* notification. NXP Semiconductors also make no representation or
+* warranty that such application will be suitable for the specified
+* use without further testing or modification.
+*
+* Permission to use, copy, modify, and distribute this software
+* and its documentation for any purpose is hereby granted without
+* fee, provided that it is used in conjunction with NXP Semiconductors
+* microcontrollers.  This copyright, permission, and disclaimer notice
+* must appear in all copies of this code.
+*/
+
+/** \file
+ *
+ *  Header file for USBTimer.c.
+ */
+
+#ifndef __USBTIMER_H__
+#define __USBTIMER_H__
+
+/* Includes: */
+#include "../../../Common/Common.h"
+
+/* Macros: */
+/** Rate of the timer service tick, the resolution of deadlines and software timers. */
+#define USB_TIMER_TICK_HZ             1000
+
+/* Type Defines: */
+/** Type define for a deadline, an absolute time in timer ticks as returned by \ref USB_Timer_Deadline(). */
+typedef uint32_t USB_Timer_Deadline_t;
+
+/** Countdown following the SysTick counter directly, started with \ref USB_Timer_StartCountdown(). Unlike a
+ *  deadline it also runs out inside interrupts that block the timer tick.
+ */
+typedef struct
+{
+	uint32_t Last;      /**< SysTick value at the previous poll. */
+	uint32_t Remaining; /**< Core clock cycles left. */
+} USB_Timer_Countdown_t;
+
+/** Type define for a software timer callback, run from the timer tick interrupt.
+ *
+ *  \param[in] Context  Context pointer given to \ref USB_Timer_Start().
+ */
+typedef void (*USB_Timer_Callback_t)(void* const Context);
+
+/** Software timer, started with \ref USB_Timer_Start(). The structure is owned by the timer service while the timer
+ *  is active and must not be modified by the application.
+ */
+typedef struct USB_Timer_t
+{
+	struct USB_Timer_t*  Next;     /**< Next active timer, by expiry. */
+	uint32_t             Expiry;   /**< Tick at which the timer fires next. */
+	uint32_t             Period;   /**< Reload period in ticks, 0 for a one-shot timer. */
+	USB_Timer_Callback_t Callback; /**< Function run when the timer fires. */
+	void*                Context;  /**< Argument passed to Callback. */
+	volatile bool        Active;   /**< True while the timer is queued. */
+} USB_Timer_t;
+
+/* External Variables: */
+/** Number of ticks since \ref USB_Timer_Init(), incremented by \ref USB_Timer_Tick(). */
+extern volatile uint32_t USB_Timer_Ticks;
+
+/* Inline Functions: */
+/** Returns the number of milliseconds elapsed since \ref USB_Timer_Init(). */
+static inline uint32_t USB_Timer_GetMS(void) ATTR_WARN_UNUSED_RESULT ATTR_ALWAYS_INLINE;
+static inline uint32_t USB_Timer_GetMS(void)
+{
+	return USB_Timer_Ticks;
+}
+
+/** Computes the deadline a given number of milliseconds from now, to be polled with \ref USB_Timer_IsExpired()
+ *  instead of spinning in a delay. The deadline expires on the Milliseconds'th tick from now, so the actual wait
+ *  is up to one tick shorter than requested.
+ *
+ *  \note Ticks only advance while the timer tick interrupt can run, so deadlines must not be polled from an
+ *        interrupt of equal or higher priority; use \ref USB_Timer_StartCountdown() there instead.
+ *
+ *  \param[in] Milliseconds  Time from now until the deadline.
+ *
+ *  \return Deadline to pass to \ref USB_Timer_IsExpired().
+ */
+static inline USB_Timer_Deadline_t USB_Timer_Deadline(const uint32_t Milliseconds) ATTR_WARN_UNUSED_RESULT ATTR_ALWAYS_INLINE;
+static inline USB_Timer_Deadline_t USB_Timer_Deadline(const uint32_t Milliseconds)
+{
+	return USB_Timer_Ticks + Milliseconds;
+}
+
+/** Determines if a deadline has passed. Deadlines up to 2^31 ticks away are handled across tick counter wrap.
+ *
+ *  \param[in] Deadline  Deadline returned by \ref USB_Timer_Deadline().
+ *
+ *  \return Boolean \c true if the deadline has passed, \c false otherwise.
+ */
+static inline bool USB_Timer_IsExpired(const USB_Timer_Deadline_t Deadline) ATTR_WARN_UNUSED_RESULT ATTR_ALWAYS_INLINE;
+static inline bool USB_Timer_IsExpired(const USB_Timer_Deadline_t Deadline)
+{
+	return ((int32_t)(USB_Timer_Ticks - Deadline) >= 0);
+}
+
+/* Function Prototypes: */
+/** Starts the timer service, running SysTick at \ref USB_TIMER_TICK_HZ from \c SystemCoreClock. This is called by
+ *  \ref USB_Init(); calling it again only reloads SysTick.
+ *
+ *  \note When the \c USB_TIMER_EXTERNAL_TICK token is defined, SysTick is left to the application and not touched
+ *        here; the application must call \ref USB_Timer_Tick() at \ref USB_TIMER_TICK_HZ itself.
+ *        \ref USB_Timer_DelayUS() then still needs SysTick to be running, and \ref USB_Timer_GetUS() also expects
+ *        it to reload at \ref USB_TIMER_TICK_HZ.
+ */
+void USB_Timer_Init(void);
+
+/** Advances the timer service by one tick and runs the software timers that have expired. Called from the SysTick
+ *  handler, or by the application when \c USB_TIMER_EXTERNAL_TICK is defined.
+ */
+void USB_Timer_Tick(void);
+
+/** Returns the number of microseconds elapsed since \ref USB_Timer_Init(), wrapping every 2^32 microseconds. */
+uint32_t USB_Timer_GetUS(void) ATTR_WARN_UNUSED_RESULT;
+
+/** Waits for the given number of microseconds by following the SysTick counter directly, so the delay is accurate
+ *  from any context, including interrupts that block the timer tick.
+ *
+ *  \note The delay is counted in core clock cycles and clamped to 2^32 of them, about 42 seconds at 100 MHz; use
+ *        \ref USB_Timer_DelayMS() for longer waits.
+ *
+ *  \param[in] Microseconds  Time to wait.
+ */
+void USB_Timer_DelayUS(uint32_t Microseconds);
+
+/** Starts a countdown of the given number of microseconds, to be polled with \ref USB_Timer_CountdownExpired().
+ *  Use it instead of \ref USB_Timer_Deadline() for waits that may run from an interrupt. Like
+ *  \ref USB_Timer_DelayUS() it is clamped to 2^32 core clock cycles.
+ *
+ *  \param[out] Countdown     Countdown to start.
+ *  \param[in]  Microseconds  Time until the countdown runs out.
+ */
+void USB_Timer_StartCountdown(USB_Timer_Countdown_t* const Countdown, uint32_t Microseconds) ATTR_NON_NULL_PTR_ARG(1);
+
+/** Determines if a countdown has run out. It must be polled at least once per SysTick period, as a longer gap
+ *  between two polls is only counted as part of a period.
+ *
+ *  \param[in,out] Countdown  Countdown started with \ref USB_Timer_StartCountdown().
+ *
+ *  \return Boolean \c true if the countdown has run out, \c false otherwise.
+ */
+bool USB_Timer_CountdownExpired(USB_Timer_Countdown_t* const Countdown) ATTR_WARN_UNUSED_RESULT ATTR_NON_NULL_PTR_ARG(1);
+
+/** Waits for the given number of milliseconds, see \ref USB_Timer_DelayUS().
+ *
+ *  \param[in] Milliseconds  Time to wait.
+ */
+void USB_Timer_DelayMS(uint32_t Milliseconds);
+
+/** Starts (or restarts) a software timer. The callback is run from the timer tick interrupt, so it must be short
+ *  and may only touch data shared with the main loop atomically. It may restart or stop its own timer.
+ *
+ *  \param[in,out] Timer     Timer to start, which must stay valid while it is active.
+ *  \param[in]     Delay     Ticks until the first expiry.
+ *  \param[in]     Period    Reload period in ticks for a periodic timer, 0 for a one-shot timer.
+ *  \param[in]     Callback  Function run on each expiry.
+ *  \param[in]     Context   Argument passed to the callback.
+ */
+void USB_Timer_Start(USB_Timer_t* const Timer,
+                     const uint32_t Delay,
+                     const uint32_t Period,
+                     USB_Timer_Callback_t Callback,
+                     void* const Context) ATTR_NON_NULL_PTR_ARG(1) ATTR_NON_NULL_PTR_ARG(4);
+
+/** Stops a software timer. Stopping a timer that is not active has no effect.
+ *
+ *  \param[in,out] Timer  Timer to stop.
+ */
+void USB_Timer_Stop(USB_Timer_t* const Timer) ATTR_NON_NULL_PTR_ARG(1);
+
+#endif /* __USBTIMER_H__ */
@@ -49,6 +49,7 @@
  *    - LPCUSBlib/Drivers/USB/Core/Events.c <i>(Makefile source module name: LPCUSBlib_SRC_USB)</i>
  *    - LPCUSBlib/Drivers/USB/Core/HostStandardReq.c <i>(Makefile source module name: LPCUSBlib_SRC_USB)</i>
  *    - LPCUSBlib/Drivers/USB/Core/USBTask.c <i>(Makefile source module name: LPCUSBlib_SRC_USB)</i>
+ *    - LPCUSBlib/Drivers/USB/Core/USBTimer.c <i>(Makefile source module name: LPCUSBlib_SRC_USB)</i>
  *    - LPCUSBlib/Drivers/USB/Core/<i>ARCH</i>/Device_<i>ARCH</i>.c <i>(Makefile source module name: LPCUSBlib_SRC_USB)</i>
  *    - LPCUSBlib/Drivers/USB/Core/<i>ARCH</i>/Endpoint_<i>ARCH</i>.c <i>(Makefile source module name: LPCUSBlib_SRC_USB)</i>
  *    - LPCUSBlib/Drivers/USB/Core/<i>ARCH</i>/EndpointStream_<i>ARCH</i>.c <i>(Makefile source module name: LPCUSBlib_SRC_USB)</i>
@@ -64,9 +65,9 @@
  *  consists of many submodules, and is designed to provide an easy way to configure and control USB host, device
  *  or OTG mode USB applications.
  *
- *  The USB stack requires the sole control over the USB controller in the microcontroller only; i.e. it does not
- *  require any additional timers or other peripherals to operate. This ensures that the USB stack requires as few
- *  resources as possible.
+ *  The USB stack requires the sole control over the USB controller in the microcontroller, and the SysTick timer
+ *  for its millisecond timer service (see USBTimer.h); it does not require any other timers or peripherals to
+ *  operate. This ensures that the USB stack requires as few resources as possible.
  *
  *  The USB stack can be used in Device Mode for connections to USB Hosts (see \ref Group_Device), in Host mode for
  *  hosting of other USB devices (see \ref Group_Host), or as a dual role device which can either act as a USB host
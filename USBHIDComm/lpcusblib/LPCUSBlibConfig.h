@@ -59,6 +59,45 @@
  */
 #define USBRAM_BUFFER_SIZE  			(4 * 1024)
 
+/** Number of fixed size blocks carved out of the USB RAM pool for each allocation size class.
+ *  Requests matching a class are served in constant time from its free list, anything else (or
+ *  any request made while its class is exhausted) falls back to the general purpose heap built
+ *  from the remainder of the pool.
+ *   - PIPE blocks are PIPE_MAX_SIZE bytes and hold bulk/control pipe buffers.
+ *   - SCRATCH blocks are 256 bytes and hold descriptor scratch/medium sized buffers.
+ *   - PACKET blocks are FIXED_CONTROL_ENDPOINT_SIZE bytes and hold max-packet interrupt buffers.
+ */
+#define USBRAM_POOL_PIPE_BLOCKS			4
+#define USBRAM_POOL_SCRATCH_BLOCKS		2
+#define USBRAM_POOL_PACKET_BLOCKS		8
+
+/** Size of the optional second USB RAM pool region. It is placed in USBRAM2_SECTION, which on LPC17xx is the
+ *  RAM3 memory region; split the 32 KB AHB SRAM of the MCU memory configuration into its two 16 KB banks
+ *  (RAM2 at 0x2007C000 and RAM3 at 0x20080000) to use it, so buffers in different regions sit on different
+ *  AHB ports. Set to 0 to keep the whole pool in a single region.
+ */
+#define USBRAM2_BUFFER_SIZE  			0
+
+/** Region host pipe buffers are allocated from, 0, 1 or USB_MEMORY_REGION_Any */
+#define USBRAM_PIPE_REGION				USB_MEMORY_REGION_Any
+
+/** Define USB_MEMORY_DEBUG to surround USB RAM pool allocations with guard words that are checked on free */
+//#define USB_MEMORY_DEBUG
+
+/** Define INTERRUPT_CONTROL_ENDPOINT to process control requests from the USB interrupt (LPC17xx device mode)
+ *  instead of from \ref USB_USBTask(), so enumeration and class requests do not depend on the main loop.
+ *  Class control request callbacks are then run in interrupt context.
+ */
+//#define INTERRUPT_CONTROL_ENDPOINT
+
+/** Define USB_DEVICE_EVENT_LATENCY_PROBE to measure, in CPU cycles, the time from a device event being posted by the
+ *  USB interrupt to the main loop collecting it (see USB_Device_EventLatency)
+ */
+//#define USB_DEVICE_EVENT_LATENCY_PROBE
+
+/** Number of parsed HID report descriptors the HID host driver keeps to skip parsing on re-enumeration, 0 to disable */
+//#define HID_HOST_PARSER_CACHE_ENTRIES	2
+
 /** This option effects only on high speed parts that need to test full speed activities */
 #define USB_FORCED_FULLSPEED			0
 
@@ -16,10 +16,11 @@
 #include <stdio.h>
 
 #include "descriptor.h"
+#include "sofclock.h"
 #include "USB.h"
 
 /** Buffer to hold the previously generated HID report, for comparison purposes inside the HID class driver. */
-static uint8_t PrevHIDReportBuffer[GENERIC_REPORT_SIZE];
+static uint8_t PrevHIDReportBuffer[GENERIC_MAX_REPORT_SIZE];
 
 /** LPCUSBlib HID Class driver interface configuration and state information. This structure is
  *  passed to all HID Class driver functions, so that multiple instances of the same class
@@ -66,14 +67,23 @@ int main(void)
 	USB_CurrentMode = USB_MODE_Device;
 	USB_Init();
 
+	// Sampling clock, disciplined to the host's SOF once configured
+	SOFClock_Init(NULL);
+
 	// Initialize ports...
 	LPC_GPIO0->FIODIR |= 0xff0;
 
-    // Enter an infinite loop, just incrementing a counter
+    // Enter an infinite loop, sleeping until the USB interrupt posts work for a task
     while(1)
     {
-    	HID_Device_USBTask(&Generic_HID_Interface);
-    	USB_USBTask();
+    	uint32_t Events = USB_Device_WaitForEvents();
+
+    	if (Events & USB_DEVICE_EVENT_Setup)
+    		USB_USBTask();
+
+    	// The SOF tick drives the idle period and report polling, the IN endpoint bit resends changed reports
+    	if (Events & (USB_DEVICE_EVENT_StartOfFrame | USB_DEVICE_EVENT_ENDPOINT(GENERIC_IN_EPNUM)))
+    		HID_Device_USBTask(&Generic_HID_Interface);
     }
     return 0 ;
 }
@@ -112,6 +122,7 @@ void EVENT_USB_Device_ControlRequest(void)
 void EVENT_USB_Device_StartOfFrame(void)
 {
 	HID_Device_MillisecondElapsed(&Generic_HID_Interface);
+	SOFClock_SOF();
 }
 
 /** HID class driver callback function for the creation of HID reports to the host.
@@ -131,6 +142,22 @@ bool CALLBACK_HID_Device_CreateHIDReport(USB_ClassInfo_HID_Device_t* const HIDIn
                                          uint16_t* const ReportSize)
 {
 	uint8_t* Data = (uint8_t*)ReportData;
+
+	if (ReportType == HID_REPORT_ITEM_Feature)
+	{
+		SOFClock_Status_t Status;
+
+		SOFClock_GetStatus(&Status);
+
+		USB_SetHIDReportField(Data, GENERIC_FEATURE_FLAGS_OFFSET, HID_VENDOR_REPORT_FIELD_BITS,
+		                      Status.Locked ? GENERIC_FEATURE_FLAG_LOCKED : 0);
+		USB_SetHIDReportField(Data, GENERIC_FEATURE_PHASE_OFFSET, 32, (uint32_t)Status.PhaseErrorNs);
+		USB_SetHIDReportField(Data, GENERIC_FEATURE_FREQ_OFFSET, 32, (uint32_t)Status.FrequencyOffsetPpb);
+
+		*ReportSize = GENERIC_FEATURE_REPORT_SIZE;
+		return false;
+	}
+
 //	uint8_t JoyStatus_LCL    = Joystick_GetStatus();
 //	uint8_t ButtonStatus_LCL = Buttons_GetStatus();
 	uint8_t ret = 0;
@@ -142,7 +169,7 @@ bool CALLBACK_HID_Device_CreateHIDReport(USB_ClassInfo_HID_Device_t* const HIDIn
 //	if (JoyStatus_LCL & JOY_DOWN)			ret |= 0x10;
 //	if (ButtonStatus_LCL & BUTTONS_BUTTON1)	ret |= 0x20;
 
-	Data[0] = ret;
+	USB_SetHIDReportField(Data, GENERIC_REPORT_STATUS_OFFSET, HID_VENDOR_REPORT_FIELD_BITS, ret);
 
 	*ReportSize = GENERIC_REPORT_SIZE;
 	return false;
@@ -162,17 +189,21 @@ void CALLBACK_HID_Device_ProcessHIDReport(USB_ClassInfo_HID_Device_t* const HIDI
                                           const void* ReportData,
                                           const uint16_t ReportSize)
 {
-	uint8_t* Data = (uint8_t*)ReportData;
+	// The status feature report is read only
+	if (ReportType != HID_REPORT_ITEM_Out)
+		return;
+
+	uint8_t LEDMask = USB_GetHIDReportField((const uint8_t*)ReportData, GENERIC_REPORT_LEDS_OFFSET, HID_VENDOR_REPORT_FIELD_BITS);
 	LPC_GPIO0->FIOSET |= (0xff << 4);
 //
-	if (Data[0] & 0x01) LPC_GPIO0->FIOCLR |= (1 << 4);
-	if (Data[0] & 0x02) LPC_GPIO0->FIOCLR |= (1 << 5);
-	if (Data[0] & 0x04) LPC_GPIO0->FIOCLR |= (1 << 6);
-	if (Data[0] & 0x08) LPC_GPIO0->FIOCLR |= (1 << 7);
-	if (Data[0] & 0x10) LPC_GPIO0->FIOCLR |= (1 << 8);
-	if (Data[0] & 0x20) LPC_GPIO0->FIOCLR |= (1 << 9);
-	if (Data[0] & 0x40) LPC_GPIO0->FIOCLR |= (1 << 10);
-	if (Data[0] & 0x80) LPC_GPIO0->FIOCLR |= (1 << 11);
+	if (LEDMask & 0x01) LPC_GPIO0->FIOCLR |= (1 << 4);
+	if (LEDMask & 0x02) LPC_GPIO0->FIOCLR |= (1 << 5);
+	if (LEDMask & 0x04) LPC_GPIO0->FIOCLR |= (1 << 6);
+	if (LEDMask & 0x08) LPC_GPIO0->FIOCLR |= (1 << 7);
+	if (LEDMask & 0x10) LPC_GPIO0->FIOCLR |= (1 << 8);
+	if (LEDMask & 0x20) LPC_GPIO0->FIOCLR |= (1 << 9);
+	if (LEDMask & 0x40) LPC_GPIO0->FIOCLR |= (1 << 10);
+	if (LEDMask & 0x80) LPC_GPIO0->FIOCLR |= (1 << 11);
 
 //	LEDs_SetAllLEDs(NewLEDMask);
 }
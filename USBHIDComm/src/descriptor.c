@@ -52,14 +52,37 @@
  */
 const USB_Descriptor_HIDReport_Datatype_t PROGMEM GenericReport[] =
 {
-	/* Use the HID class driver's standard Vendor HID report.
+	/* The HID class driver's standard Vendor HID report, see HID_DESCRIPTOR_VENDOR(), plus a feature
+	 * report carrying the sampling clock status.
 	 *  Vendor Usage Page: 1
 	 *  Vendor Collection Usage: 1
 	 *  Vendor Report IN Usage: 9
 	 *  Vendor Report OUT Usage: 8
-	 *  Vendor Report Size: GENERIC_REPORT_SIZE
+	 *  Vendor Report Feature Usage: 10
+	 *  Vendor Report Size: GENERIC_REPORT_SIZE, GENERIC_FEATURE_REPORT_SIZE
 	 */
-	HID_DESCRIPTOR_VENDOR(0x00, 0x01, 0x09, 0x08, GENERIC_REPORT_SIZE)
+	HID_RI_USAGE_PAGE(16, 0xFF00),
+	HID_RI_USAGE(8, 0x01),
+	HID_RI_COLLECTION(8, 0x01),
+		HID_RI_USAGE(8, 0x09),
+		HID_RI_LOGICAL_MINIMUM(8, 0x00),
+		HID_RI_LOGICAL_MAXIMUM(8, 0xFF),
+		HID_RI_REPORT_SIZE(8, 0x08),
+		HID_RI_REPORT_COUNT(8, GENERIC_REPORT_SIZE),
+		HID_RI_INPUT(8, HID_IOF_DATA | HID_IOF_VARIABLE | HID_IOF_ABSOLUTE),
+		HID_RI_USAGE(8, 0x08),
+		HID_RI_LOGICAL_MINIMUM(8, 0x00),
+		HID_RI_LOGICAL_MAXIMUM(8, 0xFF),
+		HID_RI_REPORT_SIZE(8, 0x08),
+		HID_RI_REPORT_COUNT(8, GENERIC_REPORT_SIZE),
+		HID_RI_OUTPUT(8, HID_IOF_DATA | HID_IOF_VARIABLE | HID_IOF_ABSOLUTE | HID_IOF_NON_VOLATILE),
+		HID_RI_USAGE(8, 0x0A),
+		HID_RI_LOGICAL_MINIMUM(8, 0x00),
+		HID_RI_LOGICAL_MAXIMUM(8, 0xFF),
+		HID_RI_REPORT_SIZE(8, 0x08),
+		HID_RI_REPORT_COUNT(8, GENERIC_FEATURE_REPORT_SIZE),
+		HID_RI_FEATURE(8, HID_IOF_DATA | HID_IOF_VARIABLE | HID_IOF_ABSOLUTE | HID_IOF_VOLATILE),
+	HID_RI_END_COLLECTION(0)
 };
 
 /** Device descriptor structure. This descriptor, located in FLASH memory, describes the overall
@@ -82,8 +105,8 @@ const USB_Descriptor_Device_t PROGMEM DeviceDescriptor =
 	.ProductID              = 0x204F,
 	.ReleaseNumber          = VERSION_BCD(00.01),
 
-	.ManufacturerStrIndex   = 0x01,
-	.ProductStrIndex        = 0x02,
+	.ManufacturerStrIndex   = STRING_ID_Manufacturer,
+	.ProductStrIndex        = STRING_ID_Product,
 	.SerialNumStrIndex      = NO_DESCRIPTOR,
 
 	.NumberOfConfigurations = FIXED_NUM_CONFIGURATIONS
@@ -146,53 +169,46 @@ const USB_Descriptor_Configuration_t PROGMEM ConfigurationDescriptor =
  *  the string descriptor with index 0 (the first index). It is actually an array of 16-bit integers, which indicate
  *  via the language ID table available at USB.org what languages the device supports for its string descriptors.
  */
-uint8_t LanguageString[] =
-{
-	USB_STRING_LEN(1),
-	DTYPE_String,
-	WBVAL(LANGUAGE_ID_ENG),
-};
-USB_Descriptor_String_t *LanguageStringPtr = (USB_Descriptor_String_t*)LanguageString;
+#define LANGUAGE_STRING       LANGUAGE_ID_ENG
+const USB_Descriptor_String_t PROGMEM LanguageString = USB_STRING_DESCRIPTOR(LANGUAGE_STRING);
 
 /** Manufacturer descriptor string. This is a Unicode string containing the manufacturer's details in human readable
  *  form, and is read out upon request by the host when the appropriate string ID is requested, listed in the Device
  *  Descriptor.
  */
-uint8_t ManufacturerString[] =
-{
-	USB_STRING_LEN(3),
-	DTYPE_String,
-	WBVAL('M'),
-	WBVAL('3'),
-	WBVAL('C'),
-};
-USB_Descriptor_String_t *ManufacturerStringPtr = (USB_Descriptor_String_t*)ManufacturerString;
+#define MANUFACTURER_STRING   'M','3','C'
+const USB_Descriptor_String_t PROGMEM ManufacturerString = USB_STRING_DESCRIPTOR(MANUFACTURER_STRING);
 
 /** Product descriptor string. This is a Unicode string containing the product's details in human readable form,
  *  and is read out upon request by the host when the appropriate string ID is requested, listed in the Device
  *  Descriptor.
  */
-uint8_t ProductString[] =
+#define PRODUCT_STRING        'M','3','C',' ','U','S','B',' ','E','x','a','m','p','l','e'
+const USB_Descriptor_String_t PROGMEM ProductString = USB_STRING_DESCRIPTOR(PRODUCT_STRING);
+
+/* Compile time consistency checks of the descriptors above */
+STATIC_ASSERT(USB_STRING_DESCRIPTOR_SIZE(MANUFACTURER_STRING) <= 0xFF, ManufacturerStringTooLong);
+STATIC_ASSERT(USB_STRING_DESCRIPTOR_SIZE(PRODUCT_STRING) <= 0xFF, ProductStringTooLong);
+STATIC_ASSERT(sizeof(USB_Descriptor_Configuration_t) ==
+              (sizeof(USB_Descriptor_Configuration_Header_t) + sizeof(USB_Descriptor_Interface_t) +
+               sizeof(USB_HID_Descriptor_HID_t) + sizeof(USB_Descriptor_Endpoint_t)), ConfigurationDescriptorPadded);
+STATIC_ASSERT(GENERIC_EPSIZE <= 64, GenericEndpointTooLarge);
+STATIC_ASSERT(GENERIC_REPORT_SIZE <= GENERIC_EPSIZE, GenericReportExceedsEndpoint);
+STATIC_ASSERT(FIXED_CONTROL_ENDPOINT_SIZE <= 64, ControlEndpointTooLarge);
+
+/** Table of every descriptor the device returns, searched by \ref CALLBACK_USB_GetDescriptor(). Adding an interface
+ *  or string only needs a new entry here, rather than another case in the request handler.
+ */
+static const USB_DescriptorTableEntry_t PROGMEM DescriptorTable[] =
 {
-	USB_STRING_LEN(15),
-	DTYPE_String,
-	WBVAL('M'),
-	WBVAL('3'),
-	WBVAL('C'),
-	WBVAL(' '),
-	WBVAL('U'),
-	WBVAL('S'),
-	WBVAL('B'),
-	WBVAL(' '),
-	WBVAL('E'),
-	WBVAL('x'),
-	WBVAL('a'),
-	WBVAL('m'),
-	WBVAL('p'),
-	WBVAL('l'),
-	WBVAL('e'),
+	{DTYPE_Device,        0,                      &DeviceDescriptor,                       sizeof(USB_Descriptor_Device_t)},
+	{DTYPE_Configuration, 0,                      &ConfigurationDescriptor,                sizeof(USB_Descriptor_Configuration_t)},
+	{DTYPE_String,        STRING_ID_Language,     &LanguageString,                         USB_STRING_DESCRIPTOR_SIZE(LANGUAGE_STRING)},
+	{DTYPE_String,        STRING_ID_Manufacturer, &ManufacturerString,                     USB_STRING_DESCRIPTOR_SIZE(MANUFACTURER_STRING)},
+	{DTYPE_String,        STRING_ID_Product,      &ProductString,                          USB_STRING_DESCRIPTOR_SIZE(PRODUCT_STRING)},
+	{HID_DTYPE_HID,       0,                      &ConfigurationDescriptor.HID_GenericHID, sizeof(USB_HID_Descriptor_HID_t)},
+	{HID_DTYPE_Report,    0,                      &GenericReport,                          sizeof(GenericReport)},
 };
-USB_Descriptor_String_t *ProductStringPtr = (USB_Descriptor_String_t*)ProductString;
 
 /*******************************************************************************
  *                      ESTRUTURAS E DEFINIÇÕES DE TIPOS					   *
@@ -227,43 +243,23 @@ uint16_t CALLBACK_USB_GetDescriptor(const uint16_t wValue,
 	const uint8_t  DescriptorType   = (wValue >> 8);
 	const uint8_t  DescriptorNumber = (wValue & 0xFF);
 
+	/* HID class descriptors are selected by interface (wIndex) rather than by descriptor number */
+	const uint8_t  EntryNumber      = ((DescriptorType == HID_DTYPE_HID) || (DescriptorType == HID_DTYPE_Report)) ?
+	                                  wIndex : DescriptorNumber;
+
 	const void* Address = NULL;
 	uint16_t    Size    = NO_DESCRIPTOR;
 
-	switch (DescriptorType)
+	uint8_t i;
+	for (i = 0; i < (sizeof(DescriptorTable) / sizeof(DescriptorTable[0])); i++)
 	{
-		case DTYPE_Device:
-			Address = &DeviceDescriptor;
-			Size    = sizeof(USB_Descriptor_Device_t);
-			break;
-		case DTYPE_Configuration:
-			Address = &ConfigurationDescriptor;
-			Size    = sizeof(USB_Descriptor_Configuration_t);
-			break;
-		case DTYPE_String:
-			switch (DescriptorNumber)
-			{
-				case 0x00:
-					Address = LanguageStringPtr;
-					Size    = pgm_read_byte(&LanguageStringPtr->Header.Size);
-				break;
-				case 0x01:
-					Address = ManufacturerStringPtr;
-					Size    = pgm_read_byte(&ManufacturerStringPtr->Header.Size);
-				break;
-				case 0x02:
-					Address = ProductStringPtr;
-					Size    = pgm_read_byte(&ProductStringPtr->Header.Size);
-				break;
-			}
-			break;
-		case HID_DTYPE_HID:
-			Address = &ConfigurationDescriptor.HID_GenericHID;
-			Size = sizeof(USB_HID_Descriptor_HID_t);
-		break;
-		case HID_DTYPE_Report:
-			Address = &GenericReport;
-			Size = sizeof(GenericReport);
+		const USB_DescriptorTableEntry_t* Entry = &DescriptorTable[i];
+
+		if ((Entry->Type != DescriptorType) || (Entry->Number != EntryNumber))
+		  continue;
+
+		Address = Entry->Address;
+		Size    = Entry->Size;
 		break;
 	}
 
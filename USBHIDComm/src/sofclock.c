@@ -0,0 +1,244 @@
+/**
+ *   Modulo: sofclock
+ *   @file sofclock.c
+ *   Veja sofclock.h para mais informações.
+ ******************************************************************************/
+
+/*******************************************************************************
+ *                             MODULOS UTILIZADOS							   *
+ ******************************************************************************/
+
+/*
+ * Inclusão de arquivos de cabeçalho da ferramenta de desenvolvimento.
+ * Por exemplo: '#include <stdlib.h>'.
+ */
+#include <stdint.h>   /* Para as definições de uint8_t/uint16_t */
+#include <stdbool.h>  /* Para as definições de true/false */
+
+/*
+ * Inclusão de arquivos de cabeçalho sem um arquivo ".c" correspondente.
+ * Por exemplo:
+ * #include "stddefs.h"
+ * #include "template_header.h"
+ */
+#ifdef __USE_CMSIS
+#include "LPC17xx.h"
+#endif
+
+/*
+ * Inclusão de arquivos de cabeçalho de outros módulos utilizados por este.
+ * Por exemplo: '#include "serial.h"'.
+ */
+#include "USB.h"
+
+/*
+ * Inclusão do arquivo de cabeçalho deste módulo.
+ */
+#include "sofclock.h"
+
+/*******************************************************************************
+ *                     CONSTANTES E DEFINICOES DE MACRO						   *
+ ******************************************************************************/
+
+/** TIMER0 clock select in PCLKSEL0: CCLK / 1, so one timer tick is one CPU cycle. */
+#define SOFCLOCK_PCLKSEL_MASK   (3 << 2)
+#define SOFCLOCK_PCLKSEL_CCLK   (1 << 2)
+
+/** Fractional bits of the period and of the loop integrator. */
+#define SOFCLOCK_FRACTION_BITS  8
+
+/*******************************************************************************
+ *                      ESTRUTURAS E DEFINIÇÕES DE TIPOS					   *
+ ******************************************************************************/
+
+/*******************************************************************************
+ *                        VARIÁVEIS PUBLICAS (Globais)						   *
+ ******************************************************************************/
+
+/*******************************************************************************
+ *                  DECLARACOES DE VARIAVEIS PRIVADAS (static)				   *
+ ******************************************************************************/
+
+static SOFClock_SampleCallback_t SampleHandler;
+
+/* Loop parameters, in timer ticks, derived from the CPU clock by SOFClock_Init() */
+static uint32_t NominalPeriod;
+static int32_t  TrimLimit;
+static int32_t  LockThreshold;
+static int32_t  UnlockThreshold;
+static int32_t  CaptureThreshold;
+
+/* Loop state, updated from the USB interrupt */
+static int32_t  FrequencyTrim;   /* Integrator, in 1/256 tick per period */
+static uint32_t PeriodResidue;   /* Fraction of a tick carried to the next period */
+static int32_t  PhaseError;
+static uint16_t LockCount;
+static volatile bool    Locked;
+static volatile uint8_t PeriodsSinceSOF;
+
+/*******************************************************************************
+ *                   PROTOTIPOS DAS FUNCOES PRIVADAS (static)				   *
+ ******************************************************************************/
+
+static int32_t TicksFromNs(const uint32_t Nanoseconds);
+
+/*******************************************************************************
+ *                      IMPLEMENTACAO DAS FUNCOES PUBLICAS					   *
+ ******************************************************************************/
+
+void SOFClock_Init(SOFClock_SampleCallback_t SampleCallback)
+{
+	SampleHandler    = SampleCallback;
+
+	NominalPeriod    = SystemCoreClock / 1000;
+	TrimLimit        = (int32_t)(((uint64_t)NominalPeriod * SOFCLOCK_MAX_TRIM_PPM << SOFCLOCK_FRACTION_BITS) / 1000000);
+	LockThreshold    = TicksFromNs(SOFCLOCK_LOCK_THRESHOLD_NS);
+	UnlockThreshold  = TicksFromNs(SOFCLOCK_UNLOCK_THRESHOLD_NS);
+	CaptureThreshold = TicksFromNs(SOFCLOCK_CAPTURE_THRESHOLD_NS);
+
+	FrequencyTrim    = 0;
+	PeriodResidue    = 0;
+	PhaseError       = 0;
+	LockCount        = 0;
+	Locked           = false;
+	PeriodsSinceSOF  = SOFCLOCK_HOLDOVER_FRAMES;
+
+	LPC_SC->PCONP    |= (1 << 1);
+	LPC_SC->PCLKSEL0  = (LPC_SC->PCLKSEL0 & ~SOFCLOCK_PCLKSEL_MASK) | SOFCLOCK_PCLKSEL_CCLK;
+
+	LPC_TIM0->TCR = 2;                 /* Hold in reset */
+	LPC_TIM0->PR  = 0;
+	LPC_TIM0->MR0 = NominalPeriod - 1;
+	LPC_TIM0->MCR = 3;                 /* Interrupt and reset on MR0 */
+	LPC_TIM0->IR  = 0x3F;
+	LPC_TIM0->TCR = 1;
+
+	NVIC_EnableIRQ(TIMER0_IRQn);
+}
+
+void SOFClock_SOF(void)
+{
+	USB_Device_FrameTime_t FrameTime;
+	uint32_t CurrentPriMask = __get_PRIMASK();
+	uint32_t Count;
+	int32_t  Period = (int32_t)LPC_TIM0->MR0 + 1;
+	int32_t  Error;
+	int32_t  AbsError;
+	uint32_t NextPeriod;
+
+	/* Timer ticks are CPU cycles, so the cycles since the SOF was latched give the count at the SOF;
+	 * nothing may run between the two reads */
+	__disable_irq();
+	Count = LPC_TIM0->TC;
+	USB_Device_GetFrameTime(&FrameTime);
+	__set_PRIMASK(CurrentPriMask);
+
+	Error = (int32_t)Count - (int32_t)FrameTime.SubFrameCycles;
+
+	if (Error < 0)
+	  Error += Period;
+	if (Error >= (Period / 2))
+	  Error -= Period;
+
+	PeriodsSinceSOF = 0;
+	PhaseError      = Error;
+	AbsError        = (Error < 0) ? -Error : Error;
+
+	if (AbsError > CaptureThreshold)
+	{
+		/* Too far off to slew, restart the period at the SOF and acquire again */
+		USB_Device_GetFrameTime(&FrameTime);
+		LPC_TIM0->TC = FrameTime.SubFrameCycles;
+
+		LockCount = 0;
+		Locked    = false;
+		return;
+	}
+
+	/* A positive error means the period ended before the SOF, so the timer runs fast and the period is lengthened */
+	FrequencyTrim += (Error * (1 << SOFCLOCK_FRACTION_BITS)) >> SOFCLOCK_KI_SHIFT;
+
+	if (FrequencyTrim > TrimLimit)
+	  FrequencyTrim = TrimLimit;
+	else if (FrequencyTrim < -TrimLimit)
+	  FrequencyTrim = -TrimLimit;
+
+	NextPeriod    = (NominalPeriod << SOFCLOCK_FRACTION_BITS) + FrequencyTrim +
+	                ((Error * (1 << SOFCLOCK_FRACTION_BITS)) >> SOFCLOCK_KP_SHIFT) + PeriodResidue;
+	PeriodResidue = NextPeriod & ((1 << SOFCLOCK_FRACTION_BITS) - 1);
+	NextPeriod  >>= SOFCLOCK_FRACTION_BITS;
+
+	/* The new match applies to the period in progress; if the count already went past it, end the
+	 * period now rather than running on to the 32-bit overflow. The count keeps its excess so the
+	 * phase is not lost, and the missed match is raised in software so no sampling tick is skipped */
+	LPC_TIM0->MR0 = NextPeriod - 1;
+	if (LPC_TIM0->TC > (NextPeriod - 1))
+	{
+		LPC_TIM0->TC -= NextPeriod;
+		NVIC_SetPendingIRQ(TIMER0_IRQn);
+	}
+
+	if (AbsError <= LockThreshold)
+	{
+		if (LockCount < SOFCLOCK_LOCK_FRAMES)
+		  LockCount++;
+		else
+		  Locked = true;
+	}
+	else if (AbsError > UnlockThreshold)
+	{
+		LockCount = 0;
+		Locked    = false;
+	}
+}
+
+void SOFClock_GetStatus(SOFClock_Status_t* const Status)
+{
+	int32_t  Error;
+	int32_t  Trim;
+	uint32_t CurrentPriMask = __get_PRIMASK();
+
+	__disable_irq();
+	Status->Locked = Locked;
+	Error          = PhaseError;
+	Trim           = FrequencyTrim;
+	__set_PRIMASK(CurrentPriMask);
+
+	Status->PhaseErrorNs       = (int32_t)(((int64_t)Error * 1000000000) / (int32_t)SystemCoreClock);
+	Status->FrequencyOffsetPpb = (int32_t)(((int64_t)Trim * 1000000000) / ((int64_t)NominalPeriod << SOFCLOCK_FRACTION_BITS));
+}
+
+/** Sampling tick: the timer period ended. Counts the periods since the last SOF so that a lost
+ *  host clock is reported, then runs the application's sampling callback.
+ */
+void TIMER0_IRQHandler(void)
+{
+	LPC_TIM0->IR = 1;
+
+	if (PeriodsSinceSOF < SOFCLOCK_HOLDOVER_FRAMES)
+	{
+		PeriodsSinceSOF++;
+	}
+	else
+	{
+		LockCount = 0;
+		Locked    = false;
+	}
+
+	if (SampleHandler != NULL)
+	  SampleHandler();
+}
+
+/******************************************************************************
+ *                    IMPLEMENTACAO DAS FUNCOES PRIVADAS					  *
+ *****************************************************************************/
+
+/** Converts a duration in nanoseconds to timer ticks at the current CPU clock. */
+static int32_t TicksFromNs(const uint32_t Nanoseconds)
+{
+	return (int32_t)(((uint64_t)Nanoseconds * SystemCoreClock) / 1000000000);
+}
+
+/******************************************************************************
+ *                                    EOF                                     *
+ *****************************************************************************/